@@ -15,7 +15,10 @@
 #include "src/state.c"
 #include "src/metrics.c"
 #include "src/proxmox.c"
+#include "src/collector.c"
+#include "src/pixel.c"
 #include "src/render.c"
 #include "src/usb.c"
+#include "src/snapshot.c"
 #include "src/cli.c"
 #include "src/main.c"
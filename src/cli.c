@@ -33,13 +33,54 @@ static int parse_positive_int(const char *arg, int *out) {
     return 0;
 }
 
+/* VID:PID[@BUS:ADDR] with hex IDs and decimal bus/address, as lsusb prints them. */
+static int parse_device_spec(const char *arg, PanelConfig *out) {
+    char buf[32];
+    if (!arg || !out || strlen(arg) >= sizeof(buf)) {
+        return -1;
+    }
+    snprintf(buf, sizeof(buf), "%s", arg);
+
+    PanelConfig cfg = {0, 0, -1, -1};
+    char *at = strchr(buf, '@');
+    if (at) {
+        *at++ = '\0';
+        char *sep = strchr(at, ':');
+        if (!sep) {
+            return -1;
+        }
+        *sep = '\0';
+        if (parse_positive_int(at, &cfg.bus) != 0 || parse_positive_int(sep + 1, &cfg.addr) != 0) {
+            return -1;
+        }
+    }
+    char *colon = strchr(buf, ':');
+    if (!colon) {
+        return -1;
+    }
+    *colon = '\0';
+    if (parse_hex_u16(buf, &cfg.vid) != 0 || parse_hex_u16(colon + 1, &cfg.pid) != 0) {
+        return -1;
+    }
+    *out = cfg;
+    return 0;
+}
+
 static void print_usage(const char *progname) {
     printf("Usage: %s [OPTIONS]\n\n", progname);
     printf("Options:\n");
     printf("  --vid HEX        USB Vendor ID  (default: 0x%04X)\n", 0x0416);
     printf("  --pid HEX        USB Product ID (default: 0x%04X)\n", 0x5302);
+    printf("  --device VID:PID[@BUS:ADDR]  Drive this panel; repeat for up to %d panels\n",
+           MAX_PANELS);
     printf("  --interval SECS  Page rotation interval (default: %d)\n", 7);
     printf("  --interface NAME  Network interface (default: auto-detect)\n");
+    printf("  --chunk-size BYTES  USB bulk submission size, multiple of %d (default: whole frame)\n",
+           PACKET_SIZE);
+    printf("  --keepalive SECS  Resend an unchanged frame after this long (default: %d)\n", 5);
+    printf("  --palette         Render 8-bit palette indices, expanded to RGB565 at send\n");
+    printf("  --render-to DIR   Write every page to DIR/<page>.ppm instead of driving a panel\n");
+    printf("  --snapshot        Render every page once, write it (to . without --render-to) and exit\n");
     printf("  --help            Show this help message\n");
 }
 
@@ -47,8 +88,14 @@ int parse_args(int argc, char **argv) {
     static struct option long_opts[] = {
         {"vid",       required_argument, NULL, 'V'},
         {"pid",       required_argument, NULL, 'P'},
+        {"device",    required_argument, NULL, 'd'},
         {"interval",  required_argument, NULL, 'i'},
         {"interface", required_argument, NULL, 'n'},
+        {"chunk-size", required_argument, NULL, 'c'},
+        {"keepalive", required_argument, NULL, 'k'},
+        {"palette",   no_argument,       NULL, 'p'},
+        {"render-to", required_argument, NULL, 'r'},
+        {"snapshot",  no_argument,       NULL, 's'},
         {"help",      no_argument,       NULL, 'h'},
         {NULL, 0, NULL, 0}
     };
@@ -75,6 +122,19 @@ int parse_args(int argc, char **argv) {
             g_pid = val;
             break;
         }
+        case 'd': {
+            PanelConfig cfg;
+            if (g_num_panels >= MAX_PANELS) {
+                fprintf(stderr, "Too many devices (max %d)\n", MAX_PANELS);
+                return -1;
+            }
+            if (parse_device_spec(optarg, &cfg) != 0) {
+                fprintf(stderr, "Invalid device: %s\n", optarg);
+                return -1;
+            }
+            g_panel_cfg[g_num_panels++] = cfg;
+            break;
+        }
         case 'i': {
             int val;
             if (parse_positive_int(optarg, &val) != 0) {
@@ -91,6 +151,37 @@ int parse_args(int argc, char **argv) {
             }
             snprintf(g_cli_iface, sizeof(g_cli_iface), "%s", optarg);
             break;
+        case 'c': {
+            int val;
+            if (parse_positive_int(optarg, &val) != 0 || val % PACKET_SIZE != 0) {
+                fprintf(stderr, "Invalid chunk size: %s\n", optarg);
+                return -1;
+            }
+            g_chunk_size = val;
+            break;
+        }
+        case 'k': {
+            int val;
+            if (parse_positive_int(optarg, &val) != 0) {
+                fprintf(stderr, "Invalid keepalive: %s\n", optarg);
+                return -1;
+            }
+            g_keepalive = val;
+            break;
+        }
+        case 'p':
+            g_palette_mode = 1;
+            break;
+        case 'r':
+            if (optarg[0] == '\0' || strlen(optarg) >= sizeof(g_render_dir)) {
+                fprintf(stderr, "Invalid render directory: %s\n", optarg);
+                return -1;
+            }
+            snprintf(g_render_dir, sizeof(g_render_dir), "%s", optarg);
+            break;
+        case 's':
+            g_snapshot = 1;
+            break;
         case 'h':
             print_usage(argv[0]);
             exit(0);
@@ -99,5 +190,8 @@ int parse_args(int argc, char **argv) {
             return -1;
         }
     }
+    if (g_snapshot && g_render_dir[0] == '\0') {
+        snprintf(g_render_dir, sizeof(g_render_dir), ".");
+    }
     return 0;
 }
@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ * Copyright (C) 2026 homelab-screen contributors
+ */
+
+#include "trlcd.h"
+
+typedef struct {
+    Metrics metrics;
+    ProxmoxMetrics pve;
+} Snapshot;
+
+/*
+ * Triple buffer between the collector and the render loop. The collector
+ * writes its slot and swaps it with the middle one; the render loop swaps
+ * its slot with the middle one when that holds a newer snapshot. Each side
+ * only ever touches the slot it holds, so neither waits on the other and
+ * the pages never see a half-written snapshot.
+ */
+#define SNAPSHOT_FRESH 4 /* set in g_snapshot_middle by each publish */
+
+static Snapshot g_snapshots[3];
+static atomic_int g_snapshot_middle = 1;
+static int g_snapshot_back = 0;  /* collector's slot */
+static int g_snapshot_front = 2; /* render loop's slot */
+
+static pthread_t g_collector_thread;
+static int g_collector_running = 0;
+static atomic_int g_collector_stop;
+
+/* Publish g_sample and g_pve_sample; called by whoever collects. */
+void metrics_publish(void) {
+    Snapshot *s = &g_snapshots[g_snapshot_back];
+    s->metrics = g_sample;
+    s->pve = g_pve_sample;
+    g_snapshot_back = atomic_exchange(&g_snapshot_middle, g_snapshot_back | SNAPSHOT_FRESH) & 3;
+}
+
+/* Take the newest snapshot into g_metrics and g_pve_metrics; 0 if none is new. */
+int metrics_update(void) {
+    if (!(atomic_load(&g_snapshot_middle) & SNAPSHOT_FRESH)) {
+        return 0;
+    }
+    g_snapshot_front = atomic_exchange(&g_snapshot_middle, g_snapshot_front) & 3;
+    g_metrics = g_snapshots[g_snapshot_front].metrics;
+    g_pve_metrics = g_snapshots[g_snapshot_front].pve;
+    return 1;
+}
+
+void collect_and_publish(void) {
+    collect_metrics();
+    collect_proxmox_metrics();
+    metrics_publish();
+}
+
+/*
+ * The collector thread runs the due collectors at the render loop's pace,
+ * so a slow read (or a Proxmox query taking seconds) only delays the
+ * numbers, never a frame.
+ */
+static void *collector_thread(void *arg) {
+    (void)arg;
+    while (!atomic_load(&g_collector_stop)) {
+        collect_and_publish();
+        struct timespec ts = {0, 100000000}; /* 100ms */
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+int collector_start(void) {
+    atomic_store(&g_collector_stop, 0);
+    if (pthread_create(&g_collector_thread, NULL, collector_thread, NULL) != 0) {
+        return -1;
+    }
+    g_collector_running = 1;
+    return 0;
+}
+
+void collector_stop(void) {
+    if (g_collector_running) {
+        atomic_store(&g_collector_stop, 1);
+        pthread_join(g_collector_thread, NULL);
+        g_collector_running = 0;
+    }
+}
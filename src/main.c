@@ -12,77 +12,184 @@ int main(int argc, char **argv) {
 
     printf("homelab-screen - Thermalright AIO Cooler USB LCD System Monitor\n");
     printf("Display: %dx%d, Page interval: %d seconds\n", LCD_W, LCD_H, g_interval);
+    printf("Pixel kernels: %s\n", pixel_kernels_name());
 
-    /* Install signal handlers for graceful shutdown */
+    /* Install signal handlers for graceful shutdown and stats dumps */
     struct sigaction sa;
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = signal_handler;
     sigemptyset(&sa.sa_mask);
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
 
-    if (usb_init() < 0) {
+    /* Headless runs (--render-to, --snapshot) never open a panel */
+    int headless = g_render_dir[0] != '\0';
+    if (!headless && usb_init() < 0) {
         return 1;
     }
 
     /* Detect network interface once at startup */
     detect_network_interface();
-    get_hostname(g_metrics.hostname, sizeof(g_metrics.hostname));
-    printf("Network interface: %s\n", g_metrics.net_iface);
+    get_hostname(g_sample.hostname, sizeof(g_sample.hostname));
+    printf("Network interface: %s\n", g_sample.net_iface);
 
     /* Check for Proxmox environment */
     check_pve_available();
-    if (g_pve_metrics.pve_available) {
+    if (g_pve_sample.pve_available) {
         printf("Proxmox VE detected, enabling PVE pages\n");
-        collect_proxmox_metrics();
     }
 
-    int current_page = 0;
-    time_t last_page_switch = time(NULL);
-
     /* Build renderer list: base pages + conditional Proxmox pages */
-    void (*renderers[8])(void);
+    void (*renderers[9])(Surface *s);
+    const char *names[9];
     int num_pages = 0;
+    names[num_pages] = "overview";
     renderers[num_pages++] = render_page_overview;
+    names[num_pages] = "cpu";
     renderers[num_pages++] = render_page_cpu;
+    names[num_pages] = "cores";
+    renderers[num_pages++] = render_page_cores;
+    names[num_pages] = "memory";
     renderers[num_pages++] = render_page_memory;
+    names[num_pages] = "network";
     renderers[num_pages++] = render_page_network;
+    names[num_pages] = "system";
     renderers[num_pages++] = render_page_system;
-    if (g_pve_metrics.pve_available) {
+    if (g_pve_sample.pve_available) {
+        names[num_pages] = "proxmox";
         renderers[num_pages++] = render_page_proxmox;
+        names[num_pages] = "storage";
         renderers[num_pages++] = render_page_storage;
     }
 
-    printf("Starting display loop (%d pages, Ctrl+C to exit)...\n", num_pages);
+    if (headless) {
+        return render_to_dir(g_render_dir, renderers, names, num_pages, g_snapshot);
+    }
+
+    /* Each panel rotates through the pages on its own, staggered by one. */
+    int num_panels = usb_panel_count();
+    int current_page[MAX_PANELS];
+    uint16_t *last_queued[MAX_PANELS] = {NULL}; /* slot each panel's last frame was drawn in */
+    for (int p = 0; p < num_panels; p++) {
+        current_page[p] = p % num_pages;
+    }
+    time_t last_page_switch = time(NULL);
+
+    /*
+     * Offscreen frame per panel the next page is rendered into a second
+     * before the switch, so the switch itself only copies it and patches
+     * the values that moved since. Without the memory pages switch cold.
+     */
+    size_t pixel_size = g_palette_mode ? 1 : sizeof(uint16_t);
+    uint8_t *next_frames = malloc((size_t)num_panels * LCD_W * LCD_H * pixel_size);
+    int next_rendered = 0;
+
+    /*
+     * With --palette pages draw 8-bit palette indices into a frame per
+     * panel, expanded to RGB565 into the transfer slot just before sending.
+     */
+    uint8_t *index_frames = NULL;
+    if (g_palette_mode) {
+        index_frames = malloc((size_t)num_panels * LCD_W * LCD_H);
+        if (!index_frames) {
+            fprintf(stderr, "Out of memory for palette frames\n");
+            free(next_frames);
+            usb_cleanup();
+            return 1;
+        }
+    }
+
+    /*
+     * The first sample is taken here so the first frame has numbers; after
+     * that the collector thread refreshes them. If it cannot start, the
+     * loop collects inline, where a slow read holds up the frame.
+     */
+    collect_and_publish();
+    int collect_inline = collector_start() < 0;
+    if (collect_inline) {
+        fprintf(stderr, "Failed to start collector thread, collecting inline\n");
+    }
+
+    printf("Starting display loop (%d pages, %d panels, Ctrl+C to exit)...\n",
+           num_pages, num_panels);
 
     while (g_running) {
-        collect_metrics();
-        collect_proxmox_metrics();
+        /* The newest snapshot is taken once per tick and shared by every panel */
+        if (collect_inline) {
+            collect_and_publish();
+        }
+        metrics_update();
 
         /* Check for page switch */
         time_t now = time(NULL);
         if (now - last_page_switch >= g_interval) {
-            current_page = (current_page + 1) % num_pages;
+            for (int p = 0; p < num_panels; p++) {
+                current_page[p] = (current_page[p] + 1) % num_pages;
+            }
             last_page_switch = now;
-            printf("\rPage %d/%d ", current_page + 1, num_pages);
+            next_rendered = 0;
+            printf("\rPage %d/%d ", current_page[0] + 1, num_pages);
             fflush(stdout);
+        } else if (next_frames && !next_rendered && now - last_page_switch >= g_interval - 1) {
+            for (int p = 0; p < num_panels; p++) {
+                uint8_t *mem = next_frames + (size_t)p * LCD_W * LCD_H * pixel_size;
+                Surface next = g_palette_mode ? surface_wrap_indexed(mem, LCD_W, LCD_H, LCD_W)
+                                              : surface_wrap((uint16_t *)mem, LCD_W, LCD_H, LCD_W);
+                renderers[(current_page[p] + 1) % num_pages](&next);
+            }
+            next_rendered = 1;
         }
 
-        /* Render current page */
-        renderers[current_page]();
-
-        /* Send to display */
-        if (send_frame() < 0) {
-            fprintf(stderr, "\nUSB send failed, exiting.\n");
-            break;
+        for (int p = 0; p < num_panels; p++) {
+            /*
+             * Render current page; frames are dropped while a panel is
+             * unplugged. A render that repainted nothing left the frame as
+             * it was: the palette frame is the one expanded last tick, an
+             * RGB slot only if send_frame kept it (no flip) last tick.
+             */
+            usb_select_panel(p);
+            int unchanged;
+            if (index_frames) {
+                Surface frame = surface_wrap_indexed(index_frames + (size_t)p * LCD_W * LCD_H,
+                                                     LCD_W, LCD_H, LCD_W);
+                renderers[current_page[p]](&frame);
+                unchanged = render_damage(&frame).w == 0;
+                surface_expand(framebuffer, &frame);
+            } else {
+                Surface frame = surface_wrap(framebuffer, LCD_W, LCD_H, LCD_W);
+                renderers[current_page[p]](&frame);
+                unchanged = framebuffer == last_queued[p] && render_damage(&frame).w == 0;
+            }
+            last_queued[p] = framebuffer;
+            if (unchanged) {
+                send_unchanged_frame();
+            } else {
+                send_frame();
+            }
         }
 
+        /* Transfer statistics on SIGUSR1, and periodically for the journal */
+        int stats_requested = g_stats_requested;
+        g_stats_requested = 0;
+        usb_report_stats(stats_requested);
+
         /* ~10 FPS for smooth updates */
         struct timespec ts = {0, 100000000}; /* 100ms */
         nanosleep(&ts, NULL);
     }
 
     printf("\nShutting down...\n");
+    if (next_frames) {
+        render_release(next_frames, (size_t)num_panels * LCD_W * LCD_H * pixel_size);
+    }
+    free(next_frames);
+    if (index_frames) {
+        render_release(index_frames, (size_t)num_panels * LCD_W * LCD_H);
+    }
+    free(index_frames);
+    collector_stop();
+    metrics_close();
     usb_cleanup();
     return 0;
 }
@@ -5,73 +5,314 @@
 
 #include "trlcd.h"
 
-static int get_cpu_usage(float *usage) {
+/* ========== Persistent Sources ========== */
+
+/*
+ * A /proc or /sys file opened once and re-read with a single pread from
+ * offset 0 on every collection. A read failing with ESTALE or ENODEV (the
+ * device behind a sysfs file went away and came back) reopens the path and
+ * reads again; any other failure closes it, so the next collection opens
+ * it afresh.
+ */
+typedef struct {
+    char path[128];
+    int fd; /* -1 while closed */
+} Source;
+
+#define SOURCE_BUF_SIZE 4096
+
+static Source g_src_stat = {"/proc/stat", -1};
+static Source g_src_meminfo = {"/proc/meminfo", -1};
+static Source g_src_uptime = {"/proc/uptime", -1};
+static Source g_src_loadavg = {"/proc/loadavg", -1};
+static Source g_src_temp[] = {
+    {"/sys/class/thermal/thermal_zone0/temp", -1},
+    {"/sys/class/hwmon/hwmon0/temp1_input", -1},
+    {"/sys/class/hwmon/hwmon1/temp1_input", -1},
+};
+static Source g_src_rx = {"", -1};
+static Source g_src_tx = {"", -1};
+
+static char g_source_buf[SOURCE_BUF_SIZE];
+
+static void source_close(Source *src) {
+    if (src->fd >= 0) {
+        close(src->fd);
+        src->fd = -1;
+    }
+}
+
+/* Point src at path, closing the old file if the path changed. */
+static void source_set_path(Source *src, const char *path) {
+    if (strcmp(src->path, path) != 0) {
+        source_close(src);
+        snprintf(src->path, sizeof(src->path), "%s", path);
+    }
+}
+
+/* Up to size - 1 bytes of src as a NUL-terminated string in buf, or NULL. */
+static const char *source_read_into(Source *src, char *buf, size_t size) {
+    for (int attempt = 0;; attempt++) {
+        if (src->fd < 0) {
+            src->fd = open(src->path, O_RDONLY | O_CLOEXEC);
+            if (src->fd < 0) return NULL;
+        }
+        ssize_t n = pread(src->fd, buf, size - 1, 0);
+        if (n >= 0) {
+            buf[n] = '\0';
+            return buf;
+        }
+        int err = errno;
+        source_close(src);
+        if (attempt == 1 || (err != ESTALE && err != ENODEV)) return NULL;
+    }
+}
+
+static const char *source_read(Source *src) {
+    return source_read_into(src, g_source_buf, sizeof(g_source_buf));
+}
+
+/* ========== Parsers ========== */
+
+/*
+ * The parsers below run over the NUL-terminated text source_read leaves in
+ * g_source_buf, without allocating and without stdio. A number must be
+ * followed by something other than the terminator, so a read cut short in
+ * the middle of a value fails instead of yielding a smaller one.
+ */
+
+/* Unsigned decimal at *p after blanks; advances *p past it. */
+static int scan_u64(const char **p, uint64_t *out) {
+    const char *s = *p;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s < '0' || *s > '9') return -1;
+
+    uint64_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        unsigned digit = (unsigned)(*s - '0');
+        if (v > (UINT64_MAX - digit) / 10) return -1;
+        v = v * 10 + digit;
+        s++;
+    }
+    if (*s == '\0') return -1;
+    *out = v;
+    *p = s;
+    return 0;
+}
+
+/* Up to max numbers of the /proc/stat line at *p, past its label; returns how many. */
+static int scan_cpu_fields(const char **p, uint64_t *fields, int max) {
+    int n = 0;
+    while (n < max && scan_u64(p, &fields[n]) == 0) {
+        n++;
+    }
+    return n;
+}
+
+static const char *next_line(const char *s) {
+    s = strchr(s, '\n');
+    return s ? s + 1 : NULL;
+}
+
+/*
+ * /proc/meminfo keys we read, found through a perfect hash: (length + 5th
+ * character) & 7 is distinct for each, so a line costs one table probe and
+ * one memcmp whatever its key.
+ */
+enum { MEM_TOTAL, MEM_FREE, MEM_AVAILABLE, MEM_BUFFERS, MEM_CACHED, MEM_KEYS };
+
+#define MEMINFO_HASH(key, len) (((len) + (unsigned char)(key)[4]) & 7)
+
+static const struct {
+    const char *key; /* NULL: free slot */
+    size_t len;
+    int id;
+} g_meminfo_keys[8] = {
+    [1] = {"MemFree", 7, MEM_FREE},
+    [2] = {"MemAvailable", 12, MEM_AVAILABLE},
+    [3] = {"Cached", 6, MEM_CACHED},
+    [4] = {"Buffers", 7, MEM_BUFFERS},
+    [7] = {"MemTotal", 8, MEM_TOTAL},
+};
+
+#define MEM_BIT(id) (1u << (id))
+#define MEM_NEED_AVAILABLE (MEM_BIT(MEM_TOTAL) | MEM_BIT(MEM_AVAILABLE))
+/* Kernels before 3.14 lack MemAvailable; free + buffers + cached stands in. */
+#define MEM_NEED_FALLBACK (MEM_BIT(MEM_TOTAL) | MEM_BIT(MEM_FREE) | MEM_BIT(MEM_BUFFERS) | MEM_BIT(MEM_CACHED))
+
+/*
+ * kB values of the meminfo keys in buf; returns the MEM_BIT mask of those
+ * found. Stops as soon as either key set is complete, which with
+ * MemAvailable is the third line.
+ */
+static unsigned parse_meminfo(const char *buf, uint64_t values[MEM_KEYS]) {
+    unsigned found = 0;
+    for (const char *line = buf; line; line = next_line(line)) {
+        const char *colon = line;
+        while (*colon && *colon != ':' && *colon != '\n') colon++;
+        if (*colon != ':') continue;
+
+        size_t len = (size_t)(colon - line);
+        if (len < 5) continue;
+        int slot = MEMINFO_HASH(line, len);
+        const char *key = g_meminfo_keys[slot].key;
+        if (!key || g_meminfo_keys[slot].len != len || memcmp(key, line, len) != 0) continue;
+
+        const char *p = colon + 1;
+        int id = g_meminfo_keys[slot].id;
+        if (scan_u64(&p, &values[id]) == 0) {
+            found |= MEM_BIT(id);
+            if ((found & MEM_NEED_AVAILABLE) == MEM_NEED_AVAILABLE ||
+                (found & MEM_NEED_FALLBACK) == MEM_NEED_FALLBACK) {
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+/* ========== System Metrics ========== */
+
+/* Jiffies of one /proc/stat cpu line: idle (with iowait) and in total. */
+typedef struct {
+    uint64_t idle;
+    uint64_t total;
+} CpuTicks;
+
+/*
+ * The fields after a cpu label are user nice system idle iowait irq softirq
+ * steal guest guest_nice; kernels before 2.6.11 stop at softirq. Steal is
+ * time the hypervisor ran something else, so it counts as busy; guest time
+ * is already part of user and nice and is not added again.
+ */
+static int scan_cpu_ticks(const char **p, CpuTicks *t) {
+    uint64_t f[8];
+    int n = scan_cpu_fields(p, f, 8);
+    if (n < 7) return -1;
+    t->idle = f[3] + f[4];
+    t->total = 0;
+    for (int i = 0; i < n; i++) {
+        t->total += f[i];
+    }
+    return 0;
+}
+
+/* Busy share between two readings in percent; 0 without an earlier one. */
+static float cpu_busy_pct(CpuTicks prev, CpuTicks now) {
+    if (prev.total == 0 || now.total <= prev.total || now.idle < prev.idle) return 0.0f;
+    uint64_t d_total = now.total - prev.total;
+    uint64_t d_idle = now.idle - prev.idle;
+    if (d_idle > d_total) return 0.0f;
+    return 100.0f * (1.0f - (float)d_idle / (float)d_total);
+}
+
+/*
+ * Per-core delta state and the /proc/stat buffer, sized on first use for
+ * the configured CPUs (at most MAX_CORES) so a read covers every cpuN line
+ * and stops before the long interrupt counters.
+ */
+#define STAT_LINE_MAX 128
+
+static CpuTicks *g_core_ticks = NULL;
+static int g_core_slots = 0;
+static char *g_stat_buf = NULL;
+static size_t g_stat_buf_size = 0;
+
+static void cpu_cores_init(void) {
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    if (n < 1) n = 1;
+    if (n > MAX_CORES) n = MAX_CORES;
+    CpuTicks *ticks = malloc((size_t)n * sizeof(CpuTicks));
+    char *buf = malloc((size_t)(n + 1) * STAT_LINE_MAX);
+    if (!ticks || !buf) {
+        free(ticks);
+        free(buf);
+        return;
+    }
+    memset(ticks, 0, (size_t)n * sizeof(CpuTicks));
+    g_core_ticks = ticks;
+    g_core_slots = (int)n;
+    g_stat_buf = buf;
+    g_stat_buf_size = (size_t)(n + 1) * STAT_LINE_MAX;
+}
+
+static void cpu_cores_free(void) {
+    free(g_core_ticks);
+    free(g_stat_buf);
+    g_core_ticks = NULL;
+    g_core_slots = 0;
+    g_stat_buf = NULL;
+    g_stat_buf_size = 0;
+}
+
+/*
+ * Aggregate usage, and per-core usage in core_pct, from one pass over
+ * /proc/stat. *cores is the highest cpuN seen plus one; offline cores in
+ * between read 0. Without memory for the per-core state *cores is 0.
+ */
+static int get_cpu_usage(float *usage, uint8_t *core_pct, int *cores) {
     *usage = 0.0f;
-    FILE *f = fopen("/proc/stat", "r");
-    if (!f) return -1;
+    *cores = 0;
+    if (!g_core_ticks) cpu_cores_init();
+    const char *buf = g_stat_buf ? source_read_into(&g_src_stat, g_stat_buf, g_stat_buf_size)
+                                 : source_read(&g_src_stat);
+    if (!buf || strncmp(buf, "cpu ", 4) != 0 || !strchr(buf, '\n')) return -1;
 
-    uint64_t user, nice, system, idle, iowait, irq, softirq;
-    if (fscanf(f, "cpu %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
-               " %" SCNu64 " %" SCNu64 " %" SCNu64,
-               &user, &nice, &system, &idle, &iowait, &irq, &softirq) != 7) {
-        fclose(f);
+    const char *p = buf + 4;
+    CpuTicks all;
+    if (scan_cpu_ticks(&p, &all) != 0) {
         return -1;
     }
-    fclose(f);
-
-    uint64_t total_idle = idle + iowait;
-    uint64_t total = user + nice + system + idle + iowait + irq + softirq;
+    *usage = cpu_busy_pct((CpuTicks){last_cpu_idle, last_cpu_total}, all);
+    last_cpu_idle = all.idle;
+    last_cpu_total = all.total;
 
-    if (last_cpu_total > 0) {
-        uint64_t d_idle = total_idle - last_cpu_idle;
-        uint64_t d_total = total - last_cpu_total;
-        if (d_total > 0) {
-            *usage = 100.0f * (1.0f - (float)d_idle / (float)d_total);
+    /* Complete cpuN lines only; a read cut short drops the last one. */
+    memset(core_pct, 0, (size_t)g_core_slots);
+    for (const char *line = next_line(p); line && strncmp(line, "cpu", 3) == 0 && strchr(line, '\n');
+         line = next_line(line)) {
+        p = line + 3;
+        uint64_t id;
+        CpuTicks t;
+        if (scan_u64(&p, &id) != 0 || id >= (uint64_t)g_core_slots || scan_cpu_ticks(&p, &t) != 0) {
+            continue;
         }
+        core_pct[id] = (uint8_t)(cpu_busy_pct(g_core_ticks[id], t) + 0.5f);
+        g_core_ticks[id] = t;
+        if ((int)id >= *cores) *cores = (int)id + 1;
     }
-    last_cpu_idle = total_idle;
-    last_cpu_total = total;
     return 0;
 }
 
 static int get_memory_info(uint64_t *used, uint64_t *total) {
-    FILE *f = fopen("/proc/meminfo", "r");
-    if (!f) return -1;
+    const char *buf = source_read(&g_src_meminfo);
+    if (!buf) return -1;
 
-    uint64_t mem_total = 0, mem_avail = 0;
-    char line[256];
-    while (fgets(line, sizeof(line), f)) {
-        if (strncmp(line, "MemTotal:", 9) == 0)
-            sscanf(line + 9, " %" SCNu64, &mem_total);
-        else if (strncmp(line, "MemAvailable:", 13) == 0)
-            sscanf(line + 13, " %" SCNu64, &mem_avail);
+    uint64_t kb[MEM_KEYS];
+    unsigned found = parse_meminfo(buf, kb);
+    uint64_t mem_avail;
+    if ((found & MEM_NEED_AVAILABLE) == MEM_NEED_AVAILABLE) {
+        mem_avail = kb[MEM_AVAILABLE];
+    } else if ((found & MEM_NEED_FALLBACK) == MEM_NEED_FALLBACK) {
+        mem_avail = kb[MEM_FREE] + kb[MEM_BUFFERS] + kb[MEM_CACHED];
+    } else {
+        return -1;
     }
-    fclose(f);
 
+    uint64_t mem_total = kb[MEM_TOTAL];
     *total = mem_total * 1024;
-    *used = (mem_total - mem_avail) * 1024;
+    *used = (mem_total > mem_avail ? mem_total - mem_avail : 0) * 1024;
     return 0;
 }
 
 static int get_cpu_temp(float *temp) {
     /* Try common thermal zone paths */
-    const char *paths[] = {
-        "/sys/class/thermal/thermal_zone0/temp",
-        "/sys/class/hwmon/hwmon0/temp1_input",
-        "/sys/class/hwmon/hwmon1/temp1_input",
-        NULL
-    };
-
-    for (int i = 0; paths[i]; i++) {
-        FILE *f = fopen(paths[i], "r");
-        if (f) {
-            int t;
-            if (fscanf(f, "%d", &t) == 1) {
-                *temp = t / 1000.0f;
-                fclose(f);
-                return 0;
-            }
-            fclose(f);
+    for (size_t i = 0; i < sizeof(g_src_temp) / sizeof(g_src_temp[0]); i++) {
+        const char *buf = source_read(&g_src_temp[i]);
+        int t;
+        if (buf && sscanf(buf, "%d", &t) == 1) {
+            *temp = t / 1000.0f;
+            return 0;
         }
     }
     return -1;
@@ -91,23 +332,17 @@ void get_hostname(char *buf, size_t len) {
 }
 
 static void get_uptime(uint64_t *secs) {
-    FILE *f = fopen("/proc/uptime", "r");
-    if (f) {
-        double up;
-        if (fscanf(f, "%lf", &up) == 1) {
-            *secs = (uint64_t)up;
-        }
-        fclose(f);
+    const char *buf = source_read(&g_src_uptime);
+    double up;
+    if (buf && sscanf(buf, "%lf", &up) == 1) {
+        *secs = (uint64_t)up;
     }
 }
 
 static void get_load_avg(float *l1, float *l5, float *l15) {
-    FILE *f = fopen("/proc/loadavg", "r");
-    if (f) {
-        if (fscanf(f, "%f %f %f", l1, l5, l15) != 3) {
-            *l1 = *l5 = *l15 = 0.0f;
-        }
-        fclose(f);
+    const char *buf = source_read(&g_src_loadavg);
+    if (buf && sscanf(buf, "%f %f %f", l1, l5, l15) != 3) {
+        *l1 = *l5 = *l15 = 0.0f;
     }
 }
 
@@ -116,13 +351,13 @@ static void get_load_avg(float *l1, float *l5, float *l15) {
 void detect_network_interface(void) {
     /* If CLI override is set, use that */
     if (g_cli_iface[0] != '\0') {
-        snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "%s", g_cli_iface);
+        snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "%s", g_cli_iface);
         return;
     }
 
     DIR *d = opendir("/sys/class/net");
     if (!d) {
-        snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+        snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
         return;
     }
 
@@ -166,9 +401,9 @@ void detect_network_interface(void) {
     closedir(d);
 
     if (best[0] != '\0') {
-        snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "%s", best);
+        snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "%s", best);
     } else {
-        snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+        snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
     }
 }
 
@@ -179,33 +414,28 @@ static float compute_counter_rate(uint64_t current, uint64_t previous, time_t dt
     return (float)(current - previous) / (float)dt;
 }
 
-static void get_network_rates(void) {
-    if (g_metrics.net_iface[0] == '\0') return;
+static void get_network_rates(time_t now) {
+    if (g_sample.net_iface[0] == '\0') return;
 
     char path[128];
     uint64_t rx = 0, tx = 0;
 
     snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/rx_bytes",
-             g_metrics.net_iface);
-    FILE *f = fopen(path, "r");
-    if (f) {
-        if (fscanf(f, "%" SCNu64, &rx) != 1) rx = 0;
-        fclose(f);
-    }
+             g_sample.net_iface);
+    source_set_path(&g_src_rx, path);
+    const char *buf = source_read(&g_src_rx);
+    if (buf && scan_u64(&buf, &rx) != 0) rx = 0;
 
     snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/tx_bytes",
-             g_metrics.net_iface);
-    f = fopen(path, "r");
-    if (f) {
-        if (fscanf(f, "%" SCNu64, &tx) != 1) tx = 0;
-        fclose(f);
-    }
+             g_sample.net_iface);
+    source_set_path(&g_src_tx, path);
+    buf = source_read(&g_src_tx);
+    if (buf && scan_u64(&buf, &tx) != 0) tx = 0;
 
-    time_t now = time(NULL);
     if (last_net_time > 0 && now > last_net_time) {
         time_t dt = now - last_net_time;
-        g_metrics.net_rx_rate = compute_counter_rate(rx, last_net_rx, dt);
-        g_metrics.net_tx_rate = compute_counter_rate(tx, last_net_tx, dt);
+        g_sample.net_rx_rate = compute_counter_rate(rx, last_net_rx, dt);
+        g_sample.net_tx_rate = compute_counter_rate(tx, last_net_tx, dt);
     }
 
     last_net_rx = rx;
@@ -213,16 +443,91 @@ static void get_network_rates(void) {
     last_net_time = now;
 }
 
-void collect_metrics(void) {
-    get_cpu_usage(&g_metrics.cpu_usage);
-    get_cpu_temp(&g_metrics.cpu_temp);
-    get_memory_info(&g_metrics.mem_used, &g_metrics.mem_total);
-    if (g_metrics.mem_total > 0) {
-        g_metrics.mem_pct = 100.0f * g_metrics.mem_used / g_metrics.mem_total;
+/* ========== Collection Schedule ========== */
+
+static void collect_cpu(time_t now) {
+    (void)now;
+    get_cpu_usage(&g_sample.cpu_usage, g_sample.core_pct, &g_sample.core_count);
+}
+
+static void collect_temp(time_t now) {
+    (void)now;
+    get_cpu_temp(&g_sample.cpu_temp);
+}
+
+static void collect_memory(time_t now) {
+    (void)now;
+    get_memory_info(&g_sample.mem_used, &g_sample.mem_total);
+    if (g_sample.mem_total > 0) {
+        g_sample.mem_pct = 100.0f * g_sample.mem_used / g_sample.mem_total;
     } else {
-        g_metrics.mem_pct = 0.0f;
+        g_sample.mem_pct = 0.0f;
+    }
+}
+
+/* Uptime as read, and when; shown advancing with the clock in between. */
+static uint64_t g_uptime_read = 0;
+static time_t g_uptime_at = 0;
+
+static void collect_uptime(time_t now) {
+    get_uptime(&g_uptime_read);
+    g_uptime_at = now;
+}
+
+static void collect_load(time_t now) {
+    (void)now;
+    get_load_avg(&g_sample.load_1, &g_sample.load_5, &g_sample.load_15);
+}
+
+/*
+ * Each collector runs when its period has passed, not on every frame:
+ * CPU and network rates are deltas over about a second, the kernel updates
+ * the load average every 5 s, and uptime only needs an occasional re-sync.
+ */
+typedef struct {
+    void (*collect)(time_t now);
+    int period; /* seconds */
+    time_t last; /* 0: not yet run */
+} Collector;
+
+static Collector g_collectors[] = {
+    {collect_cpu, 1, 0},
+    {get_network_rates, 1, 0},
+    {collect_memory, 2, 0},
+    {collect_temp, 2, 0},
+    {collect_load, 5, 0},
+    {collect_uptime, 60, 0},
+};
+
+/* Refresh the metrics that are due; g_sample keeps the rest. */
+void collect_metrics(void) {
+    time_t now = time(NULL);
+    for (size_t i = 0; i < sizeof(g_collectors) / sizeof(g_collectors[0]); i++) {
+        Collector *c = &g_collectors[i];
+        if (c->last == 0 || now - c->last >= c->period || now < c->last) {
+            c->collect(now);
+            c->last = now;
+        }
+    }
+    g_sample.uptime_secs = g_uptime_read + (now > g_uptime_at ? (uint64_t)(now - g_uptime_at) : 0);
+}
+
+/*
+ * Close every collector file and free the per-core state; the next
+ * collection reopens and resizes them and runs every collector.
+ */
+void metrics_close(void) {
+    cpu_cores_free();
+    for (size_t i = 0; i < sizeof(g_collectors) / sizeof(g_collectors[0]); i++) {
+        g_collectors[i].last = 0;
+    }
+    source_close(&g_src_stat);
+    source_close(&g_src_meminfo);
+    source_close(&g_src_uptime);
+    source_close(&g_src_loadavg);
+    for (size_t i = 0; i < sizeof(g_src_temp) / sizeof(g_src_temp[0]); i++) {
+        source_close(&g_src_temp[i]);
     }
-    get_uptime(&g_metrics.uptime_secs);
-    get_load_avg(&g_metrics.load_1, &g_metrics.load_5, &g_metrics.load_15);
-    get_network_rates();
+    source_close(&g_src_rx);
+    source_close(&g_src_tx);
 }
@@ -0,0 +1,321 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ * Copyright (C) 2026 homelab-screen contributors
+ */
+
+#include "trlcd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PIXEL_X86 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Whole-frame pixel kernels. Every kernel family has a scalar reference
+ * implementation; vector variants must produce byte-identical output and
+ * are selected once at runtime from the CPU features.
+ */
+typedef struct {
+    const char *name;
+    int (*supported)(void);
+    void (*fill16)(uint16_t *dst, uint16_t value, size_t n);
+    uint64_t (*hash64)(const void *data, size_t len);
+    void (*expand8)(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n);
+} PixelKernels;
+
+#define HASH_STEP 0x9E3779B97F4A7C15ULL
+
+static const uint64_t hash_key0[4] = {
+    0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+    0x85EBCA77C2B2AE63ULL, 0x27D4EB2F165667C5ULL
+};
+static const uint64_t hash_acc0[4] = {
+    0x61C8864680B583EBULL, 0xBF58476D1CE4E5B9ULL,
+    0x94D049BB133111EBULL, 0x2545F4914F6CDD1DULL
+};
+
+static uint64_t hash_finish(const uint64_t acc[4], size_t len) {
+    uint64_t h = len * HASH_STEP;
+    for (int l = 0; l < 4; l++) {
+        uint64_t z = acc[l] + h;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        h = (h ^ z ^ (z >> 31)) * HASH_STEP;
+    }
+    return h;
+}
+
+/* ========== Scalar reference ========== */
+
+static int scalar_supported(void) {
+    return 1;
+}
+
+static void fill16_scalar(uint16_t *dst, uint16_t value, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = value;
+    }
+}
+
+/*
+ * 64-bit content hash over 32-byte stripes, four independent 64-bit lanes
+ * per stripe. Each lane mixes its word with a per-position key through a
+ * 32x32->64 multiply, so reordered content still changes the result.
+ * len must be a multiple of 32.
+ */
+static uint64_t hash64_scalar(const void *data, size_t len) {
+    uint64_t key[4], acc[4];
+    const uint8_t *p = data;
+
+    memcpy(key, hash_key0, sizeof(key));
+    memcpy(acc, hash_acc0, sizeof(acc));
+    for (size_t off = 0; off < len; off += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t w;
+            memcpy(&w, p + off + 8 * l, sizeof(w));
+            uint64_t k = w ^ key[l];
+            acc[l] += w + (k & 0xFFFFFFFFULL) * (k >> 32);
+            key[l] += HASH_STEP;
+        }
+    }
+    return hash_finish(acc, len);
+}
+
+/* dst[i] = lut[src[i]]; every index must be below lut_size. */
+static void expand8_scalar(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n) {
+    (void)lut_size;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+/*
+ * Palettes of up to 16 entries fit a byte shuffle: the low and high bytes
+ * of every entry, as laid out in memory, become two 16-byte tables indexed
+ * by the pixel. Larger palettes take the scalar loop.
+ */
+#define EXPAND8_SHUFFLE_MAX 16
+
+static inline void expand8_tables(const uint16_t *lut, int lut_size, uint8_t lo[16], uint8_t hi[16]) {
+    memset(lo, 0, 16);
+    memset(hi, 0, 16);
+    for (int i = 0; i < lut_size; i++) {
+        const uint8_t *b = (const uint8_t *)&lut[i];
+        lo[i] = b[0];
+        hi[i] = b[1];
+    }
+}
+
+/* ========== x86: SSE2 baseline, AVX2 when the CPU has it ========== */
+
+#ifdef PIXEL_X86
+static int sse2_supported(void) {
+    return __builtin_cpu_supports("sse2");
+}
+
+__attribute__((target("sse2")))
+static void fill16_sse2(uint16_t *dst, uint16_t value, size_t n) {
+    __m128i v = _mm_set1_epi16((short)value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+    fill16_scalar(dst + i, value, n - i);
+}
+
+__attribute__((target("sse2")))
+static uint64_t hash64_sse2(const void *data, size_t len) {
+    const uint8_t *p = data;
+    __m128i key_lo = _mm_loadu_si128((const __m128i *)hash_key0);
+    __m128i key_hi = _mm_loadu_si128((const __m128i *)(hash_key0 + 2));
+    __m128i acc_lo = _mm_loadu_si128((const __m128i *)hash_acc0);
+    __m128i acc_hi = _mm_loadu_si128((const __m128i *)(hash_acc0 + 2));
+    __m128i step = _mm_set1_epi64x((long long)HASH_STEP);
+
+    for (size_t off = 0; off < len; off += 32) {
+        __m128i w_lo = _mm_loadu_si128((const __m128i *)(p + off));
+        __m128i w_hi = _mm_loadu_si128((const __m128i *)(p + off + 16));
+        __m128i k_lo = _mm_xor_si128(w_lo, key_lo);
+        __m128i k_hi = _mm_xor_si128(w_hi, key_hi);
+        acc_lo = _mm_add_epi64(acc_lo, _mm_add_epi64(w_lo,
+                 _mm_mul_epu32(k_lo, _mm_srli_epi64(k_lo, 32))));
+        acc_hi = _mm_add_epi64(acc_hi, _mm_add_epi64(w_hi,
+                 _mm_mul_epu32(k_hi, _mm_srli_epi64(k_hi, 32))));
+        key_lo = _mm_add_epi64(key_lo, step);
+        key_hi = _mm_add_epi64(key_hi, step);
+    }
+
+    uint64_t acc[4];
+    _mm_storeu_si128((__m128i *)acc, acc_lo);
+    _mm_storeu_si128((__m128i *)(acc + 2), acc_hi);
+    return hash_finish(acc, len);
+}
+
+static int avx2_supported(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+static void fill16_avx2(uint16_t *dst, uint16_t value, size_t n) {
+    __m256i v = _mm256_set1_epi16((short)value);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    fill16_scalar(dst + i, value, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t hash64_avx2(const void *data, size_t len) {
+    const uint8_t *p = data;
+    __m256i key = _mm256_loadu_si256((const __m256i *)hash_key0);
+    __m256i acc = _mm256_loadu_si256((const __m256i *)hash_acc0);
+    __m256i step = _mm256_set1_epi64x((long long)HASH_STEP);
+
+    for (size_t off = 0; off < len; off += 32) {
+        __m256i w = _mm256_loadu_si256((const __m256i *)(p + off));
+        __m256i k = _mm256_xor_si256(w, key);
+        acc = _mm256_add_epi64(acc, _mm256_add_epi64(w,
+              _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32))));
+        key = _mm256_add_epi64(key, step);
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return hash_finish(lanes, len);
+}
+
+__attribute__((target("avx2")))
+static void expand8_avx2(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n) {
+    if (lut_size > EXPAND8_SHUFFLE_MAX) {
+        expand8_scalar(dst, src, lut, lut_size, n);
+        return;
+    }
+    uint8_t lo_bytes[16], hi_bytes[16];
+    expand8_tables(lut, lut_size, lo_bytes, hi_bytes);
+    __m256i lo_tbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lo_bytes));
+    __m256i hi_tbl = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hi_bytes));
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lo = _mm256_shuffle_epi8(lo_tbl, v);
+        __m256i hi = _mm256_shuffle_epi8(hi_tbl, v);
+        /* Unpacking works per 128-bit lane: a holds pixels 0-7 and 16-23, b 8-15 and 24-31. */
+        __m256i a = _mm256_unpacklo_epi8(lo, hi);
+        __m256i b = _mm256_unpackhi_epi8(lo, hi);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i + 16), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    expand8_scalar(dst + i, src + i, lut, lut_size, n - i);
+}
+#endif
+
+/* ========== ARM NEON (always present on AArch64) ========== */
+
+#if defined(__ARM_NEON)
+static int neon_supported(void) {
+    return 1;
+}
+
+static void fill16_neon(uint16_t *dst, uint16_t value, size_t n) {
+    uint16x8_t v = vdupq_n_u16(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        vst1q_u16(dst + i, v);
+    }
+    fill16_scalar(dst + i, value, n - i);
+}
+
+static uint64_t hash64_neon(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint64x2_t key_lo = vld1q_u64(hash_key0);
+    uint64x2_t key_hi = vld1q_u64(hash_key0 + 2);
+    uint64x2_t acc_lo = vld1q_u64(hash_acc0);
+    uint64x2_t acc_hi = vld1q_u64(hash_acc0 + 2);
+    uint64x2_t step = vdupq_n_u64(HASH_STEP);
+
+    for (size_t off = 0; off < len; off += 32) {
+        uint64x2_t w_lo = vreinterpretq_u64_u8(vld1q_u8(p + off));
+        uint64x2_t w_hi = vreinterpretq_u64_u8(vld1q_u8(p + off + 16));
+        uint64x2_t k_lo = veorq_u64(w_lo, key_lo);
+        uint64x2_t k_hi = veorq_u64(w_hi, key_hi);
+        acc_lo = vaddq_u64(acc_lo, vaddq_u64(w_lo,
+                 vmull_u32(vmovn_u64(k_lo), vshrn_n_u64(k_lo, 32))));
+        acc_hi = vaddq_u64(acc_hi, vaddq_u64(w_hi,
+                 vmull_u32(vmovn_u64(k_hi), vshrn_n_u64(k_hi, 32))));
+        key_lo = vaddq_u64(key_lo, step);
+        key_hi = vaddq_u64(key_hi, step);
+    }
+
+    uint64_t acc[4];
+    vst1q_u64(acc, acc_lo);
+    vst1q_u64(acc + 2, acc_hi);
+    return hash_finish(acc, len);
+}
+
+#if defined(__aarch64__)
+static void expand8_neon(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n) {
+    if (lut_size > EXPAND8_SHUFFLE_MAX) {
+        expand8_scalar(dst, src, lut, lut_size, n);
+        return;
+    }
+    uint8_t lo_bytes[16], hi_bytes[16];
+    expand8_tables(lut, lut_size, lo_bytes, hi_bytes);
+    uint8x16_t lo_tbl = vld1q_u8(lo_bytes);
+    uint8x16_t hi_tbl = vld1q_u8(hi_bytes);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint8x16x2_t px = {{vqtbl1q_u8(lo_tbl, v), vqtbl1q_u8(hi_tbl, v)}};
+        vst2q_u8((uint8_t *)(dst + i), px);
+    }
+    expand8_scalar(dst + i, src + i, lut, lut_size, n - i);
+}
+#else
+#define expand8_neon expand8_scalar /* 32-bit NEON lacks the 16-byte table lookup */
+#endif
+#endif
+
+/* Best first; the scalar entry always matches and ends the search. */
+static const PixelKernels pixel_kernel_table[] = {
+#ifdef PIXEL_X86
+    {"avx2", avx2_supported, fill16_avx2, hash64_avx2, expand8_avx2},
+    {"sse2", sse2_supported, fill16_sse2, hash64_sse2, expand8_scalar}, /* byte shuffles need SSSE3 */
+#endif
+#if defined(__ARM_NEON)
+    {"neon", neon_supported, fill16_neon, hash64_neon, expand8_neon},
+#endif
+    {"scalar", scalar_supported, fill16_scalar, hash64_scalar, expand8_scalar},
+};
+
+static const PixelKernels *g_pixel_kernels = NULL;
+
+static const PixelKernels *pixel_kernels(void) {
+    if (!g_pixel_kernels) {
+        const PixelKernels *k = pixel_kernel_table;
+        while (!k->supported()) k++;
+        g_pixel_kernels = k;
+    }
+    return g_pixel_kernels;
+}
+
+const char *pixel_kernels_name(void) {
+    return pixel_kernels()->name;
+}
+
+void pixel_fill16(uint16_t *dst, uint16_t value, size_t n) {
+    pixel_kernels()->fill16(dst, value, n);
+}
+
+uint64_t pixel_hash64(const void *data, size_t len) {
+    return pixel_kernels()->hash64(data, len);
+}
+
+void pixel_expand8(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n) {
+    pixel_kernels()->expand8(dst, src, lut, lut_size, n);
+}
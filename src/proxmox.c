@@ -8,18 +8,18 @@
 #define PVE_COLLECT_INTERVAL 10
 
 void check_pve_available(void) {
-    g_pve_metrics.pve_available = 0;
+    g_pve_sample.pve_available = 0;
     if (access("/usr/bin/pvesh", X_OK) == 0 || access("/usr/sbin/qm", X_OK) == 0) {
-        g_pve_metrics.pve_available = 1;
+        g_pve_sample.pve_available = 1;
     }
     /* Also grab the node name once */
-    gethostname(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name));
-    g_pve_metrics.node_name[sizeof(g_pve_metrics.node_name) - 1] = '\0';
+    gethostname(g_pve_sample.node_name, sizeof(g_pve_sample.node_name));
+    g_pve_sample.node_name[sizeof(g_pve_sample.node_name) - 1] = '\0';
 }
 
 static void get_pve_vms(void) {
-    g_pve_metrics.running_vms = 0;
-    g_pve_metrics.total_vms = 0;
+    g_pve_sample.running_vms = 0;
+    g_pve_sample.total_vms = 0;
 
     FILE *fp = popen("qm list 2>/dev/null", "r");
     if (!fp) return;
@@ -29,16 +29,16 @@ static void get_pve_vms(void) {
     while (fgets(line, sizeof(line), fp)) {
         if (first) { first = 0; continue; } /* skip header */
         if (line[0] == '\n' || line[0] == '\0') continue;
-        g_pve_metrics.total_vms++;
+        g_pve_sample.total_vms++;
         if (strstr(line, "running"))
-            g_pve_metrics.running_vms++;
+            g_pve_sample.running_vms++;
     }
     pclose(fp);
 }
 
 static void get_pve_cts(void) {
-    g_pve_metrics.running_cts = 0;
-    g_pve_metrics.total_cts = 0;
+    g_pve_sample.running_cts = 0;
+    g_pve_sample.total_cts = 0;
 
     FILE *fp = popen("pct list 2>/dev/null", "r");
     if (!fp) return;
@@ -48,9 +48,9 @@ static void get_pve_cts(void) {
     while (fgets(line, sizeof(line), fp)) {
         if (first) { first = 0; continue; }
         if (line[0] == '\n' || line[0] == '\0') continue;
-        g_pve_metrics.total_cts++;
+        g_pve_sample.total_cts++;
         if (strstr(line, "running"))
-            g_pve_metrics.running_cts++;
+            g_pve_sample.running_cts++;
     }
     pclose(fp);
 }
@@ -151,11 +151,11 @@ static int parse_json_u64_field(const char *obj_start, const char *obj_end,
 }
 
 static void get_pve_storage(void) {
-    g_pve_metrics.storage_count = 0;
+    g_pve_sample.storage_count = 0;
 
     char node[64];
     snprintf(node, sizeof(node), "%s",
-             g_pve_metrics.node_name[0] ? g_pve_metrics.node_name : "localhost");
+             g_pve_sample.node_name[0] ? g_pve_sample.node_name : "localhost");
     for (size_t i = 0; node[i] != '\0'; i++) {
         char c = node[i];
         if (!((c >= 'a' && c <= 'z') ||
@@ -189,7 +189,7 @@ static void get_pve_storage(void) {
             /* Parse per object to avoid field bleed between entries. */
             const char *buf_end = buf + total;
             const char *p = buf;
-            while (g_pve_metrics.storage_count < 8) {
+            while (g_pve_sample.storage_count < 8) {
                 const char *storage_key = find_in_range(p, buf_end, "\"storage\"");
                 if (!storage_key) {
                     break;
@@ -209,11 +209,11 @@ static void get_pve_storage(void) {
                 }
                 obj_end++; /* exclusive */
 
-                int idx = g_pve_metrics.storage_count;
+                int idx = g_pve_sample.storage_count;
 
                 if (parse_json_string_field(obj_start, obj_end, "storage",
-                                            g_pve_metrics.storage[idx].name,
-                                            sizeof(g_pve_metrics.storage[idx].name)) != 0) {
+                                            g_pve_sample.storage[idx].name,
+                                            sizeof(g_pve_sample.storage[idx].name)) != 0) {
                     p = obj_end;
                     continue;
                 }
@@ -221,25 +221,25 @@ static void get_pve_storage(void) {
                 uint64_t used_val = 0, total_val = 0;
                 if (parse_json_u64_field(obj_start, obj_end, "used", &used_val) == 0 &&
                     parse_json_u64_field(obj_start, obj_end, "total", &total_val) == 0) {
-                    g_pve_metrics.storage[idx].used_bytes = used_val;
-                    g_pve_metrics.storage[idx].total_bytes = total_val;
+                    g_pve_sample.storage[idx].used_bytes = used_val;
+                    g_pve_sample.storage[idx].total_bytes = total_val;
                     if (total_val > 0) {
-                        g_pve_metrics.storage[idx].used_pct =
+                        g_pve_sample.storage[idx].used_pct =
                             100.0f * (float)used_val / (float)total_val;
                     } else {
-                        g_pve_metrics.storage[idx].used_pct = 0.0f;
+                        g_pve_sample.storage[idx].used_pct = 0.0f;
                     }
                 } else {
-                    g_pve_metrics.storage[idx].used_bytes = 0;
-                    g_pve_metrics.storage[idx].total_bytes = 0;
-                    g_pve_metrics.storage[idx].used_pct = 0.0f;
+                    g_pve_sample.storage[idx].used_bytes = 0;
+                    g_pve_sample.storage[idx].total_bytes = 0;
+                    g_pve_sample.storage[idx].used_pct = 0.0f;
                 }
 
-                g_pve_metrics.storage_count++;
+                g_pve_sample.storage_count++;
                 p = obj_end;
             }
 
-            if (g_pve_metrics.storage_count > 0) {
+            if (g_pve_sample.storage_count > 0) {
                 return;
             }
         }
@@ -247,7 +247,7 @@ static void get_pve_storage(void) {
 
     /* Fallback: parse df for common PVE storage paths */
     const char *pve_paths[] = {"/var/lib/vz", "/var/lib/pve/local-btrfs", NULL};
-    for (int i = 0; pve_paths[i] && g_pve_metrics.storage_count < 8; i++) {
+    for (int i = 0; pve_paths[i] && g_pve_sample.storage_count < 8; i++) {
         char cmd[128];
         snprintf(cmd, sizeof(cmd), "df -B1 %s 2>/dev/null", pve_paths[i]);
         fp = popen(cmd, "r");
@@ -260,16 +260,16 @@ static void get_pve_storage(void) {
             uint64_t total_b = 0, used_b = 0;
             char fs[64];
             if (sscanf(line, "%63s %" SCNu64 " %" SCNu64, fs, &total_b, &used_b) >= 3) {
-                int idx = g_pve_metrics.storage_count;
-                snprintf(g_pve_metrics.storage[idx].name, sizeof(g_pve_metrics.storage[idx].name),
+                int idx = g_pve_sample.storage_count;
+                snprintf(g_pve_sample.storage[idx].name, sizeof(g_pve_sample.storage[idx].name),
                          "%s", pve_paths[i] + 9); /* trim /var/lib/ prefix */
-                g_pve_metrics.storage[idx].used_bytes = used_b;
-                g_pve_metrics.storage[idx].total_bytes = total_b;
+                g_pve_sample.storage[idx].used_bytes = used_b;
+                g_pve_sample.storage[idx].total_bytes = total_b;
                 if (total_b > 0)
-                    g_pve_metrics.storage[idx].used_pct = 100.0f * (float)used_b / (float)total_b;
+                    g_pve_sample.storage[idx].used_pct = 100.0f * (float)used_b / (float)total_b;
                 else
-                    g_pve_metrics.storage[idx].used_pct = 0.0f;
-                g_pve_metrics.storage_count++;
+                    g_pve_sample.storage[idx].used_pct = 0.0f;
+                g_pve_sample.storage_count++;
             }
         }
         pclose(fp);
@@ -277,29 +277,29 @@ static void get_pve_storage(void) {
 }
 
 static void get_pve_version(void) {
-    g_pve_metrics.pve_version[0] = '\0';
+    g_pve_sample.pve_version[0] = '\0';
 
     FILE *fp = popen("pveversion 2>/dev/null", "r");
     if (fp) {
-        if (fgets(g_pve_metrics.pve_version, sizeof(g_pve_metrics.pve_version), fp)) {
-            g_pve_metrics.pve_version[strcspn(g_pve_metrics.pve_version, "\n")] = '\0';
+        if (fgets(g_pve_sample.pve_version, sizeof(g_pve_sample.pve_version), fp)) {
+            g_pve_sample.pve_version[strcspn(g_pve_sample.pve_version, "\n")] = '\0';
         }
         pclose(fp);
-        if (g_pve_metrics.pve_version[0] != '\0') return;
+        if (g_pve_sample.pve_version[0] != '\0') return;
     }
 
     /* Fallback: try reading /etc/pve/.version */
     FILE *f = fopen("/etc/pve/.version", "r");
     if (f) {
-        if (fgets(g_pve_metrics.pve_version, sizeof(g_pve_metrics.pve_version), f)) {
-            g_pve_metrics.pve_version[strcspn(g_pve_metrics.pve_version, "\n")] = '\0';
+        if (fgets(g_pve_sample.pve_version, sizeof(g_pve_sample.pve_version), f)) {
+            g_pve_sample.pve_version[strcspn(g_pve_sample.pve_version, "\n")] = '\0';
         }
         fclose(f);
     }
 }
 
 void collect_proxmox_metrics(void) {
-    if (!g_pve_metrics.pve_available) return;
+    if (!g_pve_sample.pve_available) return;
 
     time_t now = time(NULL);
     if (now - last_pve_collect < PVE_COLLECT_INTERVAL) return;
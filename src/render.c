@@ -215,67 +215,271 @@ static const uint8_t font8x16[][16] = {
     {0x00,0x00,0x3B,0x6E,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
 };
 
+/* ========== Palette ========== */
+
+/*
+ * Indexed surfaces hold one byte per pixel into a shared palette of
+ * little-endian RGB565 entries, which surface_expand() turns into wire
+ * pixels. Entries are added as colors are first drawn, so the theme's
+ * dozen colors fit the vector kernels' 16-entry limit; past 256 distinct
+ * colors the nearest entry stands in.
+ */
+#define PALETTE_SIZE 256
+
+static uint16_t g_palette[PALETTE_SIZE];
+static int g_palette_count = 0;
+static int g_palette_last = 0; /* primitives ask for one color many times in a row */
+
+static int color_distance(uint16_t a, uint16_t b) {
+    int dr = ((a >> 11) & 0x1F) - ((b >> 11) & 0x1F);
+    int dg = ((a >> 5) & 0x3F) - ((b >> 5) & 0x3F);
+    int db = (a & 0x1F) - (b & 0x1F);
+    return 4 * dr * dr + dg * dg + 4 * db * db; /* red and blue have half green's steps */
+}
+
+static uint8_t palette_index(uint16_t color) {
+    uint16_t px = htole16(color);
+    if (g_palette_count > 0 && g_palette[g_palette_last] == px) return (uint8_t)g_palette_last;
+    for (int i = 0; i < g_palette_count; i++) {
+        if (g_palette[i] == px) {
+            g_palette_last = i;
+            return (uint8_t)i;
+        }
+    }
+    if (g_palette_count < PALETTE_SIZE) {
+        g_palette[g_palette_count] = px;
+        g_palette_last = g_palette_count++;
+        return (uint8_t)g_palette_last;
+    }
+    int best = 0;
+    for (int i = 1; i < PALETTE_SIZE; i++) {
+        if (color_distance(le16toh(g_palette[i]), color) < color_distance(le16toh(g_palette[best]), color)) {
+            best = i;
+        }
+    }
+    return (uint8_t)best;
+}
+
+/* Expand an indexed surface into w x h packed RGB565 pixels at dst. */
+void surface_expand(uint16_t *dst, const Surface *s) {
+    if (s->stride == s->w) {
+        pixel_expand8(dst, s->idx, g_palette, g_palette_count, (size_t)s->w * s->h);
+        return;
+    }
+    for (int y = 0; y < s->h; y++) {
+        pixel_expand8(dst + y * s->w, s->idx + y * s->stride, g_palette, g_palette_count, (size_t)s->w);
+    }
+}
+
 /* ========== Drawing Functions ========== */
 
-static inline void set_pixel(int x, int y, uint16_t color) {
-    if (x >= 0 && x < LCD_W && y >= 0 && y < LCD_H) {
-        framebuffer[y * LCD_W + x] = color;
+/* Surface over w x h pixels at px, rows stride pixels apart; drawing is not clipped further. */
+Surface surface_wrap(uint16_t *px, int w, int h, int stride) {
+    return (Surface){px, NULL, w, h, stride, {0, 0, w, h}};
+}
+
+/* The same over palette indices. */
+Surface surface_wrap_indexed(uint8_t *idx, int w, int h, int stride) {
+    return (Surface){NULL, idx, w, h, stride, {0, 0, w, h}};
+}
+
+/* Pixel memory of either kind, which identifies the frame. */
+static const void *surface_pixels(const Surface *s) {
+    return s->idx ? (const void *)s->idx : (const void *)s->px;
+}
+
+static inline void set_pixel(Surface *s, int x, int y, uint16_t color) {
+    if (x >= s->clip.x && x < s->clip.x + s->clip.w && y >= s->clip.y && y < s->clip.y + s->clip.h) {
+        if (s->idx) {
+            s->idx[y * s->stride + x] = palette_index(color);
+        } else {
+            s->px[y * s->stride + x] = htole16(color);
+        }
     }
 }
 
-static void fill_rect(int x, int y, int w, int h, uint16_t color) {
-    for (int j = y; j < y + h && j < LCD_H; j++) {
-        for (int i = x; i < x + w && i < LCD_W; i++) {
-            if (i >= 0 && j >= 0) {
-                framebuffer[j * LCD_W + i] = color;
-            }
+/* Whether the box lies wholly inside the clip, so it may be drawn unchecked. */
+static int clip_contains(Surface *s, int x, int y, int w, int h) {
+    return x >= s->clip.x && y >= s->clip.y &&
+           x + w <= s->clip.x + s->clip.w && y + h <= s->clip.y + s->clip.h;
+}
+
+static void fill_rect(Surface *s, int x, int y, int w, int h, uint16_t color) {
+    int x0 = x < s->clip.x ? s->clip.x : x;
+    int y0 = y < s->clip.y ? s->clip.y : y;
+    int x1 = x + w < s->clip.x + s->clip.w ? x + w : s->clip.x + s->clip.w;
+    int y1 = y + h < s->clip.y + s->clip.h ? y + h : s->clip.y + s->clip.h;
+    if (x0 >= x1) return;
+
+    if (s->idx) {
+        uint8_t i = palette_index(color);
+        for (int j = y0; j < y1; j++) {
+            memset(s->idx + j * s->stride + x0, i, (size_t)(x1 - x0));
         }
+        return;
+    }
+    color = htole16(color);
+    for (int j = y0; j < y1; j++) {
+        pixel_fill16(s->px + j * s->stride + x0, color, (size_t)(x1 - x0));
     }
 }
 
-static void draw_rounded_rect(int x, int y, int w, int h, int r, uint16_t color) {
-    /* Fill main rectangles */
-    fill_rect(x + r, y, w - 2*r, h, color);
-    fill_rect(x, y + r, r, h - 2*r, color);
-    fill_rect(x + w - r, y + r, r, h - 2*r, color);
+/* ========== Rounded Corners ========== */
+
+#define CORNER_MAX_RADIUS 32
 
-    /* Draw corners */
+/* Row cy of a radius-r top-left corner is covered from column inset to r - 1. */
+static int corner_inset(int r, int cy) {
+    int dy = r - 1 - cy;
+    int cx = 0;
+    while ((r - 1 - cx) * (r - 1 - cx) + dy * dy > r * r) cx++;
+    return cx;
+}
+
+static uint8_t g_corner_insets[CORNER_MAX_RADIUS + 1][CORNER_MAX_RADIUS];
+static uint8_t g_corner_built[CORNER_MAX_RADIUS + 1];
+
+/* Per-radius inset table, built on first use of the radius. */
+static const uint8_t *corner_spans(int r) {
+    if (!g_corner_built[r]) {
+        for (int cy = 0; cy < r; cy++) {
+            g_corner_insets[r][cy] = (uint8_t)corner_inset(r, cy);
+        }
+        g_corner_built[r] = 1;
+    }
+    return g_corner_insets[r];
+}
+
+/*
+ * Cards are drawn as one span per row: full-width rows between the
+ * corners, inset rows through them. Boxes too small for two corners per
+ * side keep the overlapping rectangle-plus-corners form.
+ */
+static void draw_rounded_rect(Surface *s, int x, int y, int w, int h, int r, uint16_t color) {
+    const uint8_t *insets = (r > 0 && r <= CORNER_MAX_RADIUS) ? corner_spans(r) : NULL;
+
+    if (r > 0 && w >= 2*r && h >= 2*r) {
+        fill_rect(s, x, y + r, w, h - 2*r, color);
+        for (int cy = 0; cy < r; cy++) {
+            int inset = insets ? insets[cy] : corner_inset(r, cy);
+            fill_rect(s, x + inset, y + cy, w - 2*inset, 1, color);
+            fill_rect(s, x + inset, y + h - 1 - cy, w - 2*inset, 1, color);
+        }
+        return;
+    }
+
+    fill_rect(s, x + r, y, w - 2*r, h, color);
+    fill_rect(s, x, y + r, r, h - 2*r, color);
+    fill_rect(s, x + w - r, y + r, r, h - 2*r, color);
     for (int cy = 0; cy < r; cy++) {
-        for (int cx = 0; cx < r; cx++) {
-            int dx = r - 1 - cx;
-            int dy = r - 1 - cy;
-            if (dx*dx + dy*dy <= r*r) {
-                set_pixel(x + cx, y + cy, color);
-                set_pixel(x + w - 1 - cx, y + cy, color);
-                set_pixel(x + cx, y + h - 1 - cy, color);
-                set_pixel(x + w - 1 - cx, y + h - 1 - cy, color);
+        int inset = insets ? insets[cy] : corner_inset(r, cy);
+        int len = r - inset;
+        fill_rect(s, x + inset, y + cy, len, 1, color);
+        fill_rect(s, x + w - r, y + cy, len, 1, color);
+        fill_rect(s, x + inset, y + h - 1 - cy, len, 1, color);
+        fill_rect(s, x + w - r, y + h - 1 - cy, len, 1, color);
+    }
+}
+
+/* ========== Glyph Span Cache ========== */
+
+#define FONT_GLYPHS ((int)(sizeof(font8x16) / sizeof(font8x16[0])))
+#define GLYPH_MAX_SCALE 5
+
+/* One horizontal run of set font bits, scaled; it covers scale rows from y. */
+typedef struct {
+    uint8_t x, y, w;
+} GlyphSpan;
+
+/* Every glyph's spans at one scale, glyph g owning spans[first[g]..first[g+1]). */
+typedef struct {
+    int built;
+    uint16_t first[FONT_GLYPHS + 1];
+    GlyphSpan spans[FONT_GLYPHS * 16 * 4]; /* at most 4 runs in 8 bits */
+} GlyphCache;
+
+static GlyphCache g_glyph_cache[GLYPH_MAX_SCALE];
+
+/* Convert the font bitmap into runs pre-scaled by scale, once per scale. */
+static const GlyphCache *glyph_cache(int scale) {
+    GlyphCache *gc = &g_glyph_cache[scale - 1];
+    if (gc->built) return gc;
+
+    int n = 0;
+    for (int g = 0; g < FONT_GLYPHS; g++) {
+        gc->first[g] = (uint16_t)n;
+        for (int row = 0; row < 16; row++) {
+            uint8_t bits = font8x16[g][row];
+            int col = 0;
+            while (col < 8) {
+                if (!(bits & (0x80 >> col))) {
+                    col++;
+                    continue;
+                }
+                int start = col;
+                while (col < 8 && (bits & (0x80 >> col))) col++;
+                gc->spans[n++] = (GlyphSpan){(uint8_t)(start * scale), (uint8_t)(row * scale),
+                                             (uint8_t)((col - start) * scale)};
             }
         }
     }
+    gc->first[FONT_GLYPHS] = (uint16_t)n;
+    gc->built = 1;
+    return gc;
 }
 
-static void draw_char(int x, int y, char c, uint16_t color, int scale) {
+/*
+ * Glyphs are drawn as span fills. Clipping is decided once per glyph: fully
+ * visible glyphs fill straight into the surface, edge glyphs go through
+ * the clipping fill_rect and clipped-out glyphs are skipped. Scales above
+ * GLYPH_MAX_SCALE multiply the unit-scale spans.
+ */
+static void draw_char(Surface *s, int x, int y, char c, uint16_t color, int scale) {
     if (c < 0x20 || c > 0x7E) c = '?';
     int idx = c - 0x20;
-    if (idx >= (int)(sizeof(font8x16)/sizeof(font8x16[0]))) return;
-
-    for (int row = 0; row < 16; row++) {
-        uint8_t bits = font8x16[idx][row];
-        for (int col = 0; col < 8; col++) {
-            if (bits & (0x80 >> col)) {
-                for (int sy = 0; sy < scale; sy++) {
-                    for (int sx = 0; sx < scale; sx++) {
-                        set_pixel(x + col*scale + sx, y + row*scale + sy, color);
-                    }
-                }
+    if (idx >= FONT_GLYPHS || scale < 1) return;
+
+    int gw = 8 * scale, gh = 16 * scale;
+    if (x >= s->clip.x + s->clip.w || y >= s->clip.y + s->clip.h ||
+        x + gw <= s->clip.x || y + gh <= s->clip.y) return;
+
+    int mul = scale <= GLYPH_MAX_SCALE ? 1 : scale;
+    const GlyphCache *gc = glyph_cache(scale <= GLYPH_MAX_SCALE ? scale : 1);
+    const GlyphSpan *sp = gc->spans + gc->first[idx];
+    const GlyphSpan *end = gc->spans + gc->first[idx + 1];
+
+    if (!clip_contains(s, x, y, gw, gh)) {
+        for (; sp < end; sp++) {
+            fill_rect(s, x + sp->x * mul, y + sp->y * mul, sp->w * mul, scale, color);
+        }
+        return;
+    }
+
+    if (s->idx) {
+        uint8_t i = palette_index(color);
+        for (; sp < end; sp++) {
+            uint8_t *row = s->idx + (y + sp->y * mul) * s->stride + x + sp->x * mul;
+            for (int r = 0; r < scale; r++, row += s->stride) {
+                memset(row, i, (size_t)(sp->w * mul));
             }
         }
+        return;
+    }
+
+    /* Spans are at most 40 pixels; an inline store loop beats a kernel call. */
+    uint16_t px = htole16(color);
+    for (; sp < end; sp++) {
+        uint16_t *row = s->px + (y + sp->y * mul) * s->stride + x + sp->x * mul;
+        int w = sp->w * mul;
+        for (int r = 0; r < scale; r++, row += s->stride) {
+            for (int i = 0; i < w; i++) row[i] = px;
+        }
     }
 }
 
-static void draw_string(int x, int y, const char *str, uint16_t color, int scale) {
+static void draw_string(Surface *s, int x, int y, const char *str, uint16_t color, int scale) {
     while (*str) {
-        draw_char(x, y, *str, color, scale);
+        draw_char(s, x, y, *str, color, scale);
         x += 8 * scale;
         str++;
     }
@@ -285,40 +489,162 @@ static int string_width(const char *str, int scale) {
     return strlen(str) * 8 * scale;
 }
 
-static void draw_string_centered(int y, const char *str, uint16_t color, int scale) {
+static void draw_string_centered(Surface *s, int y, const char *str, uint16_t color, int scale) {
     int w = string_width(str, scale);
-    int x = (LCD_W - w) / 2;
-    draw_string(x, y, str, color, scale);
+    int x = (s->w - w) / 2;
+    draw_string(s, x, y, str, color, scale);
+}
+
+/* Foreground width of a progress bar; slivers too short to round are dropped. */
+static int progress_fill_width(int w, float pct) {
+    int fill_w = (int)((w - 4) * (pct / 100.0f));
+    return fill_w > 4 ? fill_w : 0;
 }
 
 /* Progress bar with rounded ends */
-static void draw_progress_bar(int x, int y, int w, int h, float pct, uint16_t bg_color, uint16_t fg_color) {
+static void draw_progress_bar(Surface *s, int x, int y, int w, int h, float pct, uint16_t bg_color, uint16_t fg_color) {
     int r = h / 2;
 
     /* Background */
-    draw_rounded_rect(x, y, w, h, r, bg_color);
+    draw_rounded_rect(s, x, y, w, h, r, bg_color);
 
     /* Foreground */
-    int fill_w = (int)((w - 4) * (pct / 100.0f));
-    if (fill_w > 4) {
-        draw_rounded_rect(x + 2, y + 2, fill_w, h - 4, r - 2, fg_color);
+    int fill_w = progress_fill_width(w, pct);
+    if (fill_w > 0) {
+        draw_rounded_rect(s, x + 2, y + 2, fill_w, h - 4, r - 2, fg_color);
     }
 }
 
-/* Circular progress indicator */
-static void draw_circle_progress(int cx, int cy, int radius, int thickness, float pct, uint16_t bg_color, uint16_t fg_color) {
-    float angle_max = (pct / 100.0f) * 2.0f * M_PI;
+/* ========== Gauge Ring Geometry ========== */
+
+/* One ring pixel: offset from the centre and its clockwise angle from 12 o'clock. */
+typedef struct {
+    float angle;
+    int16_t dx, dy;
+} RingPixel;
+
+/* Pixels of one (radius, thickness) ring sorted by angle, built on first use. */
+typedef struct {
+    int radius;
+    int thickness;
+    int count;
+    RingPixel *px;
+} RingGeometry;
+
+#define RING_CACHE_SIZE 4
+
+static RingGeometry g_rings[RING_CACHE_SIZE];
+
+static int ring_in_band(int x, int y, int radius, int thickness) {
+    float dist = sqrtf(x*x + y*y);
+    return dist >= radius - thickness && dist <= radius;
+}
+
+static int ring_pixel_cmp(const void *a, const void *b) {
+    float fa = ((const RingPixel *)a)->angle;
+    float fb = ((const RingPixel *)b)->angle;
+    return (fa > fb) - (fa < fb);
+}
+
+/*
+ * The trig runs here once per ring shape; a page only ever uses a couple of
+ * shapes, so a full cache simply rebuilds its last entry. Returns NULL when
+ * the pixel table cannot be allocated.
+ */
+static const RingGeometry *ring_geometry(int radius, int thickness) {
+    RingGeometry *slot = NULL;
+    for (int i = 0; i < RING_CACHE_SIZE; i++) {
+        RingGeometry *g = &g_rings[i];
+        if (g->px && g->radius == radius && g->thickness == thickness) {
+            return g;
+        }
+        if (!g->px && !slot) {
+            slot = g;
+        }
+    }
+    if (!slot) {
+        slot = &g_rings[RING_CACHE_SIZE - 1];
+        free(slot->px);
+        slot->px = NULL;
+    }
 
+    int count = 0;
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            count += ring_in_band(x, y, radius, thickness);
+        }
+    }
+    RingPixel *px = malloc((size_t)count * sizeof(*px));
+    if (!px) {
+        return NULL;
+    }
+    int n = 0;
     for (int y = -radius; y <= radius; y++) {
         for (int x = -radius; x <= radius; x++) {
-            float dist = sqrtf(x*x + y*y);
-            if (dist >= radius - thickness && dist <= radius) {
+            if (ring_in_band(x, y, radius, thickness)) {
                 float angle = atan2f(-x, -y) + M_PI; /* Start from top */
-                uint16_t color = (angle <= angle_max) ? fg_color : bg_color;
-                set_pixel(cx + x, cy + y, color);
+                px[n++] = (RingPixel){angle, (int16_t)x, (int16_t)y};
             }
         }
     }
+    qsort(px, (size_t)count, sizeof(*px), ring_pixel_cmp);
+
+    slot->radius = radius;
+    slot->thickness = thickness;
+    slot->count = count;
+    slot->px = px;
+    return slot;
+}
+
+/* Number of ring pixels up to pct, i.e. the length of the foreground prefix. */
+static int ring_split(const RingGeometry *ring, float pct) {
+    float angle_max = (pct / 100.0f) * 2.0f * M_PI;
+    int split = 0, hi = ring->count;
+    while (split < hi) {
+        int mid = (split + hi) / 2;
+        if (ring->px[mid].angle <= angle_max) {
+            split = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return split;
+}
+
+/* Paint ring pixels [from, to) in one color. */
+static void draw_ring_range(Surface *s, const RingGeometry *ring, int cx, int cy, int from, int to, uint16_t color) {
+    int inside = clip_contains(s, cx - ring->radius, cy - ring->radius, 2 * ring->radius + 1, 2 * ring->radius + 1);
+    if (inside && s->idx) {
+        uint8_t *center = s->idx + cy * s->stride + cx;
+        uint8_t i = palette_index(color);
+        for (int k = from; k < to; k++) {
+            center[ring->px[k].dy * s->stride + ring->px[k].dx] = i;
+        }
+        return;
+    }
+    if (inside) {
+        uint16_t *center = s->px + cy * s->stride + cx;
+        uint16_t px = htole16(color);
+        for (int i = from; i < to; i++) {
+            center[ring->px[i].dy * s->stride + ring->px[i].dx] = px;
+        }
+        return;
+    }
+    for (int i = from; i < to; i++) {
+        set_pixel(s, cx + ring->px[i].dx, cy + ring->px[i].dy, color);
+    }
+}
+
+/*
+ * Circular progress indicator: the foreground is the prefix of the
+ * angle-sorted ring up to pct, the background the rest.
+ */
+static void draw_circle_progress(Surface *s, int cx, int cy, int radius, int thickness, float pct, uint16_t bg_color, uint16_t fg_color) {
+    const RingGeometry *ring = ring_geometry(radius, thickness);
+    if (!ring) return;
+    int split = ring_split(ring, pct);
+    draw_ring_range(s, ring, cx, cy, 0, split, fg_color);
+    draw_ring_range(s, ring, cx, cy, split, ring->count, bg_color);
 }
 
 static void format_bytes_rate(float bytes_per_sec, char *buf, size_t len) {
@@ -333,105 +659,648 @@ static void format_bytes_rate(float bytes_per_sec, char *buf, size_t len) {
     }
 }
 
-void render_page_cpu(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
+/* ========== Retained Widgets ========== */
+
+/*
+ * Pages draw in two layers: a static layer (background, cards, labels)
+ * painted only when a render target shows a different layout, and widgets
+ * whose value or text is compared against what the same target holds from
+ * its previous frame. The static layer of each layout is rasterized once
+ * into a background, keyed by the one text it shows (hostname, interface
+ * or node name), and copied in instead of being drawn again. Old text is
+ * erased by copying the background back under it; then only changed
+ * widgets, and widgets overlapping what was repainted, are drawn again.
+ * The union of repainted areas is the frame's damage. Targets are keyed by
+ * pixel memory, as each transfer slot keeps the frame last drawn into it.
+ *
+ * Within one layout id the page must declare the same widget sequence, with
+ * the same geometry for gauges and bars; conditional text is declared as ""
+ * instead of being left out.
+ */
+enum {
+    LAYOUT_OVERVIEW,
+    LAYOUT_CPU,
+    LAYOUT_MEMORY,
+    LAYOUT_NETWORK,
+    LAYOUT_SYSTEM,
+    LAYOUT_CORES,
+    LAYOUT_PROXMOX,
+    LAYOUT_STORAGE, /* + number of pools shown, 0-4 */
+    LAYOUT_COUNT = LAYOUT_STORAGE + 5,
+};
+
+enum {
+    WIDGET_TEXT,
+    WIDGET_GAUGE,
+    WIDGET_BAR,
+};
+
+/*
+ * a/b are the scale for text, radius/thickness for gauges and width/height
+ * for bars; value is what the widget paints from its input (ring pixels in
+ * the foreground, bar fill width), so inputs that round to the same pixels
+ * compare equal.
+ */
+typedef struct {
+    uint8_t kind;
+    int16_t x, y, a, b;
+    int16_t value;
+    float pct;
+    uint16_t fg, bg;
+    char text[64];
+} Widget;
+
+#define RENDER_MAX_WIDGETS 24
+#define RENDER_TARGETS (MAX_PANELS * 3) /* two transfer slots and one offscreen frame per panel */
+
+typedef void (*StaticLayer)(Surface *s);
+
+/* A layout's static layer, rebuilt when the text it depends on changes. */
+typedef struct {
+    Surface surface; /* px NULL until allocated */
+    int valid;
+    char key[64];
+} Background;
+
+typedef struct {
+    Surface surface;
+    int layout; /* -1: contents unknown */
+    char key[64];
+    int count;
+    Widget widgets[RENDER_MAX_WIDGETS];
+    int cell_count;           /* heatmap cells last drawn, 0: none */
+    uint8_t cells[MAX_CORES]; /* their heat levels */
+    Rect damage;              /* repainted by the last frame */
+} RenderTarget;
+
+/*
+ * A frame being drawn, from render_begin to render_end. Pages keep it on
+ * their stack, so nothing of a frame in progress is shared; only the
+ * retained targets and backgrounds below outlive it.
+ */
+typedef struct {
+    RenderTarget *target;
+    Surface surface;
+    StaticLayer static_layer;
+    Surface *background; /* NULL: static layer drawn into the frame */
+    int count;
+    Widget widgets[RENDER_MAX_WIDGETS];
+    Rect damage;
+} RenderFrame;
+
+static RenderTarget g_targets[RENDER_TARGETS];
+static int g_target_next = 0;
+static Background g_backgrounds[2][LAYOUT_COUNT]; /* RGB565, indexed */
+
+static void target_forget(RenderTarget *t) {
+    t->surface.px = NULL;
+    t->surface.idx = NULL;
+    t->layout = -1;
+    t->damage = (Rect){0, 0, 0, 0};
+}
+
+/* Drop the targets drawn into the len bytes at mem, which is about to be freed. */
+void render_release(const void *mem, size_t len) {
+    const uint8_t *lo = mem;
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        const uint8_t *px = surface_pixels(&g_targets[i].surface);
+        if (px && px >= lo && px < lo + len) {
+            target_forget(&g_targets[i]);
+        }
+    }
+}
+
+/* Bounds of the area repainted by the last frame drawn into s; w == 0 if none. */
+Rect render_damage(const Surface *s) {
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        if (surface_pixels(&g_targets[i].surface) == surface_pixels(s)) return g_targets[i].damage;
+    }
+    return (Rect){0, 0, 0, 0};
+}
+
+static int rect_empty(Rect r) {
+    return r.w <= 0 || r.h <= 0;
+}
+
+static int rect_intersects(Rect a, Rect b) {
+    return !rect_empty(a) && !rect_empty(b) &&
+           a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+/* r clipped to the surface's clip rectangle. */
+static Rect clip_rect(const Surface *s, Rect r) {
+    int x0 = r.x < s->clip.x ? s->clip.x : r.x;
+    int y0 = r.y < s->clip.y ? s->clip.y : r.y;
+    int x1 = r.x + r.w < s->clip.x + s->clip.w ? r.x + r.w : s->clip.x + s->clip.w;
+    int y1 = r.y + r.h < s->clip.y + s->clip.h ? r.y + r.h : s->clip.y + s->clip.h;
+    if (x0 >= x1 || y0 >= y1) return (Rect){0, 0, 0, 0};
+    return (Rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+static void damage_add(RenderFrame *f, Rect r) {
+    r = clip_rect(&f->surface, r);
+    if (rect_empty(r)) return;
+    Rect *d = &f->damage;
+    int x0 = r.x, y0 = r.y, x1 = r.x + r.w, y1 = r.y + r.h;
+    if (!rect_empty(*d)) {
+        if (d->x < x0) x0 = d->x;
+        if (d->y < y0) y0 = d->y;
+        if (d->x + d->w > x1) x1 = d->x + d->w;
+        if (d->y + d->h > y1) y1 = d->y + d->h;
+    }
+    *d = (Rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+static Rect widget_bounds(const Widget *w) {
+    switch (w->kind) {
+    case WIDGET_TEXT:
+        return (Rect){w->x, w->y, string_width(w->text, w->a), 16 * w->a};
+    case WIDGET_GAUGE:
+        return (Rect){w->x - w->a, w->y - w->a, 2 * w->a + 1, 2 * w->a + 1};
+    default:
+        return (Rect){w->x, w->y, w->a, w->b};
+    }
+}
+
+/* Whether the widget paints any pixel of r; gauges leave their centre alone. */
+static int widget_overlaps(const Widget *w, Rect r) {
+    if (!rect_intersects(widget_bounds(w), r)) return 0;
+    if (w->kind != WIDGET_GAUGE) return 1;
+    int inner = w->a - w->b;
+    int x[2] = {r.x - w->x, r.x + r.w - 1 - w->x};
+    int y[2] = {r.y - w->y, r.y + r.h - 1 - w->y};
+    for (int i = 0; i < 4; i++) {
+        if (x[i & 1] * x[i & 1] + y[i >> 1] * y[i >> 1] >= inner * inner) return 1;
+    }
+    return 0;
+}
+
+static int widget_same(const Widget *a, const Widget *b) {
+    return a->kind == b->kind && a->x == b->x && a->y == b->y &&
+           a->a == b->a && a->b == b->b && a->value == b->value &&
+           a->fg == b->fg && a->bg == b->bg && strcmp(a->text, b->text) == 0;
+}
 
-    draw_string_centered(15, "CPU", COLOR_WHITE, 3);
+static void widget_draw(Surface *s, const Widget *w) {
+    switch (w->kind) {
+    case WIDGET_TEXT:
+        draw_string(s, w->x, w->y, w->text, w->fg, w->a);
+        break;
+    case WIDGET_GAUGE:
+        draw_circle_progress(s, w->x, w->y, w->a, w->b, w->pct, w->bg, w->fg);
+        break;
+    default:
+        draw_progress_bar(s, w->x, w->y, w->a, w->b, w->pct, w->bg, w->fg);
+        break;
+    }
+}
+
+/*
+ * Widgets beyond RENDER_MAX_WIDGETS are drawn on the spot and the target
+ * is forgotten, so the next frame falls back to a full redraw. render_end
+ * may still paint over them, so the whole frame counts as damaged.
+ */
+static void widget_push(RenderFrame *f, const Widget *w) {
+    if (f->count == RENDER_MAX_WIDGETS) {
+        widget_draw(&f->surface, w);
+        damage_add(f, f->surface.clip);
+        f->target->layout = -1;
+        return;
+    }
+    f->widgets[f->count++] = *w;
+}
+
+/* Copy text into a fixed field of len bytes, cutting it if needed. */
+static void copy_text(char *dst, size_t len, const char *text) {
+    size_t n = strlen(text);
+    if (n >= len) n = len - 1;
+    memcpy(dst, text, n);
+    dst[n] = '\0';
+}
+
+static void text_widget(RenderFrame *f, int x, int y, const char *text, uint16_t fg, int scale) {
+    Widget w = {.kind = WIDGET_TEXT, .x = x, .y = y, .a = scale, .fg = fg};
+    copy_text(w.text, sizeof(w.text), text);
+    widget_push(f, &w);
+}
+
+static void text_widget_centered(RenderFrame *f, int y, const char *text, uint16_t fg, int scale) {
+    text_widget(f, (f->surface.w - string_width(text, scale)) / 2, y, text, fg, scale);
+}
+
+static void gauge_widget(RenderFrame *f, int cx, int cy, int radius, int thickness, float pct, uint16_t bg, uint16_t fg) {
+    const RingGeometry *ring = ring_geometry(radius, thickness);
+    Widget w = {.kind = WIDGET_GAUGE, .x = cx, .y = cy, .a = radius, .b = thickness,
+                .value = ring ? ring_split(ring, pct) : 0, .pct = pct, .fg = fg, .bg = bg};
+    widget_push(f, &w);
+}
+
+static void bar_widget(RenderFrame *f, int x, int y, int w, int h, float pct, uint16_t bg, uint16_t fg) {
+    Widget bar = {.kind = WIDGET_BAR, .x = x, .y = y, .a = w, .b = h,
+                  .value = progress_fill_width(w, pct), .pct = pct, .fg = fg, .bg = bg};
+    widget_push(f, &bar);
+}
+
+/*
+ * Background of layout for key in the pixel format of s, rasterized on
+ * first use and whenever key changes. NULL without memory for it; the
+ * static layer is then drawn straight into the frame.
+ */
+static Surface *page_background(const Surface *s, int layout, StaticLayer static_layer, const char *key) {
+    Background *bg = &g_backgrounds[s->idx != NULL][layout];
+    if (bg->valid && strcmp(bg->key, key) == 0) return &bg->surface;
+    if (!surface_pixels(&bg->surface)) {
+        void *px = malloc(s->idx ? (size_t)LCD_W * LCD_H : FRAME_SIZE);
+        if (!px) return NULL;
+        bg->surface = s->idx ? surface_wrap_indexed(px, LCD_W, LCD_H, LCD_W)
+                             : surface_wrap(px, LCD_W, LCD_H, LCD_W);
+    }
+    static_layer(&bg->surface);
+    copy_text(bg->key, sizeof(bg->key), key);
+    bg->valid = 1;
+    return &bg->surface;
+}
+
+/* Retained state of the frame in s; unknown memory takes the oldest entry. */
+static RenderTarget *render_target(const Surface *s) {
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        if (surface_pixels(&g_targets[i].surface) == surface_pixels(s)) return &g_targets[i];
+    }
+    RenderTarget *t = &g_targets[g_target_next];
+    g_target_next = (g_target_next + 1) % RENDER_TARGETS;
+    t->surface = *s;
+    t->layout = -1;
+    return t;
+}
+
+/*
+ * Another frame of the same size and pixel format already showing layout
+ * with key, e.g. the next page pre-rendered offscreen, or NULL.
+ */
+static RenderTarget *render_peer(const RenderTarget *t, int layout, const char *key) {
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        RenderTarget *peer = &g_targets[i];
+        if (peer != t && surface_pixels(&peer->surface) && peer->layout == layout &&
+            !peer->surface.idx == !t->surface.idx &&
+            peer->surface.w == t->surface.w && peer->surface.h == t->surface.h &&
+            strcmp(peer->key, key) == 0) {
+            return peer;
+        }
+    }
+    return NULL;
+}
+
+/* Copy src pixels into dst inside r, clipped to both; the formats must match. */
+static void surface_copy_rect(Surface *dst, const Surface *src, Rect r) {
+    r = clip_rect(src, clip_rect(dst, r));
+    size_t bpp = dst->idx ? 1 : sizeof(uint16_t);
+    uint8_t *d = dst->idx ? dst->idx : (uint8_t *)dst->px;
+    const uint8_t *sp = src->idx ? src->idx : (const uint8_t *)src->px;
+    for (int y = r.y; y < r.y + r.h; y++) {
+        memcpy(d + ((size_t)y * dst->stride + r.x) * bpp, sp + ((size_t)y * src->stride + r.x) * bpp,
+               (size_t)r.w * bpp);
+    }
+}
+
+/* Restore the static layer inside r, from the background when there is one. */
+static void render_erase(RenderFrame *f, Rect r) {
+    if (!f->background) {
+        Surface view = f->surface;
+        view.clip = clip_rect(&f->surface, r);
+        f->static_layer(&view);
+        return;
+    }
+    surface_copy_rect(&f->surface, f->background, r);
+}
+
+/*
+ * Start a frame into s. A target that does not already hold this layout
+ * with the same key is seeded from a peer frame that does, widgets
+ * included, so only changed values are drawn; failing that, from the
+ * background.
+ */
+static void render_begin(RenderFrame *f, Surface *s, int layout, StaticLayer static_layer,
+                         const char *key) {
+    RenderTarget *t = render_target(s);
+    f->target = t;
+    f->surface = *s;
+    f->static_layer = static_layer;
+    f->background = page_background(s, layout, static_layer, key);
+    f->count = 0;
+    f->damage = (Rect){0, 0, 0, 0};
+    if (t->layout != layout || strcmp(t->key, key) != 0) {
+        RenderTarget *peer = render_peer(t, layout, key);
+        t->layout = layout;
+        copy_text(t->key, sizeof(t->key), key);
+        t->count = 0;
+        t->cell_count = 0;
+        if (peer) {
+            surface_copy_rect(s, &peer->surface, s->clip);
+            memcpy(t->widgets, peer->widgets, sizeof(Widget) * peer->count);
+            t->count = peer->count;
+            memcpy(t->cells, peer->cells, (size_t)peer->cell_count);
+            t->cell_count = peer->cell_count;
+        } else {
+            render_erase(f, s->clip);
+        }
+        damage_add(f, s->clip);
+    }
+}
+
+/*
+ * Paint the frame's widgets against what the target held. Changed text is
+ * first erased; then, in declaration order, every widget that changed or
+ * overlaps a repainted area is drawn again. A gauge that only moved
+ * repaints just the ring pixels in between.
+ */
+static void render_end(RenderFrame *f) {
+    RenderTarget *t = f->target;
+    Surface *s = &f->surface;
+    Rect dirty[2 * RENDER_MAX_WIDGETS];
+    int ndirty = 0;
+    int changed[RENDER_MAX_WIDGETS];
+
+    for (int i = 0; i < f->count; i++) {
+        const Widget *old = i < t->count ? &t->widgets[i] : NULL;
+        changed[i] = !old || !widget_same(old, &f->widgets[i]);
+        if (changed[i] && old && old->kind == WIDGET_TEXT) {
+            dirty[ndirty] = widget_bounds(old);
+            render_erase(f, dirty[ndirty]);
+            damage_add(f, dirty[ndirty++]);
+        }
+    }
+
+    for (int i = 0; i < f->count; i++) {
+        const Widget *w = &f->widgets[i];
+        int overlapped = 0;
+        for (int d = 0; d < ndirty && !overlapped; d++) {
+            overlapped = widget_overlaps(w, dirty[d]);
+        }
+        if (!changed[i] && !overlapped) continue;
+
+        const Widget *old = i < t->count ? &t->widgets[i] : NULL;
+        Widget moved;
+        if (old) {
+            moved = *old;
+            moved.value = w->value;
+        }
+        if (!overlapped && w->kind == WIDGET_GAUGE && old && widget_same(&moved, w)) {
+            const RingGeometry *ring = ring_geometry(w->a, w->b);
+            if (ring) {
+                int lo = old->value < w->value ? old->value : w->value;
+                int hi = old->value < w->value ? w->value : old->value;
+                draw_ring_range(s, ring, w->x, w->y, lo, hi, old->value < w->value ? w->fg : w->bg);
+            }
+        } else {
+            widget_draw(s, w);
+        }
+        dirty[ndirty] = widget_bounds(w);
+        damage_add(f, dirty[ndirty++]);
+    }
+
+    t->damage = f->damage;
+    if (t->layout != -1) {
+        memcpy(t->widgets, f->widgets, sizeof(Widget) * f->count);
+        t->count = f->count;
+    }
+}
+
+static void cpu_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 15, "CPU", COLOR_WHITE, 3);
+}
+
+void render_page_cpu(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_CPU, cpu_static, "");
 
     int cx = LCD_W / 2;
     int cy = 155;
     int radius = 85;
-    draw_circle_progress(cx, cy, radius, 14, g_metrics.cpu_usage, COLOR_BG_GAUGE, COLOR_CYAN);
+    gauge_widget(&f, cx, cy, radius, 14, g_metrics.cpu_usage, COLOR_BG_GAUGE, COLOR_CYAN);
 
     char buf[32];
     snprintf(buf, sizeof(buf), "%.0f", g_metrics.cpu_usage);
     int w = string_width(buf, 5);
-    draw_string(cx - w/2, cy - 30, buf, COLOR_WHITE, 5);
-    draw_string(cx + w/2 + 4, cy - 10, "%", COLOR_GRAY, 2);
+    text_widget(&f, cx - w/2, cy - 30, buf, COLOR_WHITE, 5);
+    text_widget(&f, cx + w/2 + 4, cy - 10, "%", COLOR_GRAY, 2);
 
+    buf[0] = '\0';
+    uint16_t temp_color = COLOR_GREEN;
     if (g_metrics.cpu_temp > 0) {
         snprintf(buf, sizeof(buf), "%.0f", g_metrics.cpu_temp);
-        uint16_t temp_color = (g_metrics.cpu_temp > 80) ? COLOR_RED :
-                              (g_metrics.cpu_temp > 60) ? COLOR_ORANGE : COLOR_GREEN;
-        int tw = string_width(buf, 4);
-        int tx = (LCD_W - tw - 24) / 2;
-        draw_string(tx, 268, buf, temp_color, 4);
-        draw_string(tx + tw + 2, 268, "'C", COLOR_GRAY, 2);
+        temp_color = (g_metrics.cpu_temp > 80) ? COLOR_RED :
+                     (g_metrics.cpu_temp > 60) ? COLOR_ORANGE : COLOR_GREEN;
+    }
+    int tw = string_width(buf, 4);
+    int tx = (LCD_W - tw - 24) / 2;
+    text_widget(&f, tx, 268, buf, temp_color, 4);
+    text_widget(&f, tx + tw + 2, 268, buf[0] ? "'C" : "", COLOR_GRAY, 2);
+    render_end(&f);
+}
+
+/* ========== Core Heatmap ========== */
+
+#define HEATMAP_X 10
+#define HEATMAP_Y 42
+#define HEATMAP_W (LCD_W - 20)
+#define HEATMAP_H 236
+#define HEATMAP_GAP 2
+
+/* Heat levels from idle to pegged: level i covers usage up to max percent. */
+static const struct {
+    uint8_t max;
+    uint16_t color;
+} g_heat_levels[] = {
+    {9, COLOR_BG_CARD}, {29, COLOR_TEAL}, {59, COLOR_GREEN},
+    {79, COLOR_YELLOW}, {94, COLOR_ORANGE}, {100, COLOR_RED},
+};
+
+static uint8_t heat_level(int pct) {
+    uint8_t level = 0;
+    while (level + 1 < (int)(sizeof(g_heat_levels) / sizeof(g_heat_levels[0])) &&
+           pct > g_heat_levels[level].max) {
+        level++;
+    }
+    return level;
+}
+
+/*
+ * Cell positions for a core count, laid out once per count: square cells
+ * as large as the heatmap area allows, the grid centred in it.
+ */
+typedef struct {
+    int count;
+    int size; /* cell side without the gap */
+    int16_t x[MAX_CORES], y[MAX_CORES];
+} HeatmapGrid;
+
+static HeatmapGrid g_heatmap_grid;
+
+static const HeatmapGrid *heatmap_grid(int count) {
+    HeatmapGrid *g = &g_heatmap_grid;
+    if (g->count == count) return g;
+
+    int cols = 1, pitch = 0;
+    for (int c = 1; c <= count; c++) {
+        int rows = (count + c - 1) / c;
+        int p = HEATMAP_W / c < HEATMAP_H / rows ? HEATMAP_W / c : HEATMAP_H / rows;
+        if (p > pitch) {
+            pitch = p;
+            cols = c;
+        }
+    }
+    int rows = (count + cols - 1) / cols;
+    int x0 = HEATMAP_X + (HEATMAP_W - cols * pitch + HEATMAP_GAP) / 2;
+    int y0 = HEATMAP_Y + (HEATMAP_H - rows * pitch + HEATMAP_GAP) / 2;
+    for (int i = 0; i < count; i++) {
+        g->x[i] = (int16_t)(x0 + (i % cols) * pitch);
+        g->y[i] = (int16_t)(y0 + (i / cols) * pitch);
+    }
+    g->size = pitch - HEATMAP_GAP;
+    g->count = count;
+    return g;
+}
+
+/*
+ * Heatmap cells, retained per target like widgets: a cell is filled again
+ * only when its heat level changed. The cells sit apart from the page's
+ * widgets, so neither repaints the other.
+ */
+static void heatmap_cells(RenderFrame *f, const uint8_t *pct, int count) {
+    RenderTarget *t = f->target;
+    const HeatmapGrid *g = heatmap_grid(count);
+    int known = t->cell_count == count;
+    for (int i = 0; i < count; i++) {
+        uint8_t level = heat_level(pct[i]);
+        if (known && t->cells[i] == level) continue;
+        fill_rect(&f->surface, g->x[i], g->y[i], g->size, g->size, g_heat_levels[level].color);
+        damage_add(f, (Rect){g->x[i], g->y[i], g->size, g->size});
+        t->cells[i] = level;
     }
+    t->cell_count = count;
 }
 
-void render_page_memory(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
+static void cores_static(Surface *s) {
+    char title[32];
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    if (g_metrics.core_count == 0) {
+        draw_string_centered(s, 10, "CORES", COLOR_WHITE, 2);
+        draw_string_centered(s, 140, "No per-core", COLOR_DARK_GRAY, 2);
+        draw_string_centered(s, 170, "data", COLOR_DARK_GRAY, 2);
+        return;
+    }
+    snprintf(title, sizeof(title), "%d CORES", g_metrics.core_count);
+    draw_string_centered(s, 10, title, COLOR_WHITE, 2);
+}
 
-    draw_string_centered(15, "RAM", COLOR_WHITE, 3);
+/* One cell per core, colored by usage, and the busiest core named below. */
+void render_page_cores(Surface *s) {
+    int count = g_metrics.core_count;
+    char key[16];
+    snprintf(key, sizeof(key), "%d", count);
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_CORES, cores_static, key);
+
+    heatmap_cells(&f, g_metrics.core_pct, count);
+
+    char buf[32] = "";
+    uint16_t color = COLOR_GRAY;
+    if (count > 0) {
+        int busiest = 0;
+        for (int i = 1; i < count; i++) {
+            if (g_metrics.core_pct[i] > g_metrics.core_pct[busiest]) busiest = i;
+        }
+        snprintf(buf, sizeof(buf), "max cpu%d %d%%", busiest, g_metrics.core_pct[busiest]);
+        color = g_heat_levels[heat_level(g_metrics.core_pct[busiest])].color;
+        if (color == COLOR_BG_CARD) color = COLOR_GRAY;
+    }
+    text_widget_centered(&f, 286, buf, color, 2);
+    render_end(&f);
+}
+
+static void memory_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 15, "RAM", COLOR_WHITE, 3);
+}
+
+void render_page_memory(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_MEMORY, memory_static, "");
 
     int cx = LCD_W / 2;
     int cy = 155;
     int radius = 85;
     uint16_t mem_color = (g_metrics.mem_pct > 90) ? COLOR_RED :
                          (g_metrics.mem_pct > 70) ? COLOR_ORANGE : COLOR_BLUE;
-    draw_circle_progress(cx, cy, radius, 14, g_metrics.mem_pct, COLOR_BG_GAUGE, mem_color);
+    gauge_widget(&f, cx, cy, radius, 14, g_metrics.mem_pct, COLOR_BG_GAUGE, mem_color);
 
     char buf[32];
     snprintf(buf, sizeof(buf), "%.0f", g_metrics.mem_pct);
     int w = string_width(buf, 5);
-    draw_string(cx - w/2, cy - 30, buf, COLOR_WHITE, 5);
-    draw_string(cx + w/2 + 4, cy - 10, "%", COLOR_GRAY, 2);
+    text_widget(&f, cx - w/2, cy - 30, buf, COLOR_WHITE, 5);
+    text_widget(&f, cx + w/2 + 4, cy - 10, "%", COLOR_GRAY, 2);
 
     float used_gb = g_metrics.mem_used / (1024.0 * 1024.0 * 1024.0);
     float total_gb = g_metrics.mem_total / (1024.0 * 1024.0 * 1024.0);
     snprintf(buf, sizeof(buf), "%.1f/%.0f", used_gb, total_gb);
     int mw = string_width(buf, 3);
     int mx = (LCD_W - mw - 24) / 2;
-    draw_string(mx, 268, buf, COLOR_GRAY, 3);
-    draw_string(mx + mw + 2, 270, "GB", COLOR_DARK_GRAY, 2);
+    text_widget(&f, mx, 268, buf, COLOR_GRAY, 3);
+    text_widget(&f, mx + mw + 2, 270, "GB", COLOR_DARK_GRAY, 2);
+    render_end(&f);
 }
 
-void render_page_network(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
-
-    draw_string_centered(15, "NET", COLOR_WHITE, 3);
-
-    /* Interface name */
-    draw_string_centered(60, g_metrics.net_iface, COLOR_TEAL, 2);
+static void network_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 15, "NET", COLOR_WHITE, 3);
+    draw_string_centered(s, 60, g_metrics.net_iface, COLOR_TEAL, 2);
+    draw_rounded_rect(s, 10, 90, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 98, "RX", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 10, 195, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 203, "TX", COLOR_DARK_GRAY, 1);
+}
 
-    /* RX card */
-    draw_rounded_rect(10, 90, LCD_W - 20, 90, 8, COLOR_BG_CARD);
-    draw_string(20, 98, "RX", COLOR_DARK_GRAY, 1);
+void render_page_network(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_NETWORK, network_static, g_metrics.net_iface);
 
     char buf[32];
     format_bytes_rate(g_metrics.net_rx_rate, buf, sizeof(buf));
-    draw_string(20, 118, buf, COLOR_GREEN, 3);
+    text_widget(&f, 20, 118, buf, COLOR_GREEN, 3);
 
     /* RX bar */
     float rx_pct = 0.0f;
     if (g_metrics.net_rx_rate > 0) {
         rx_pct = fminf(100.0f, g_metrics.net_rx_rate / (125000000.0f) * 100.0f); /* Scale to 1 Gbps */
     }
-    draw_progress_bar(20, 160, LCD_W - 40, 10, rx_pct, COLOR_BG, COLOR_GREEN);
-
-    /* TX card */
-    draw_rounded_rect(10, 195, LCD_W - 20, 90, 8, COLOR_BG_CARD);
-    draw_string(20, 203, "TX", COLOR_DARK_GRAY, 1);
+    bar_widget(&f, 20, 160, LCD_W - 40, 10, rx_pct, COLOR_BG, COLOR_GREEN);
 
     format_bytes_rate(g_metrics.net_tx_rate, buf, sizeof(buf));
-    draw_string(20, 223, buf, COLOR_ORANGE, 3);
+    text_widget(&f, 20, 223, buf, COLOR_ORANGE, 3);
 
     /* TX bar */
     float tx_pct = 0.0f;
     if (g_metrics.net_tx_rate > 0) {
         tx_pct = fminf(100.0f, g_metrics.net_tx_rate / (125000000.0f) * 100.0f);
     }
-    draw_progress_bar(20, 265, LCD_W - 40, 10, tx_pct, COLOR_BG, COLOR_ORANGE);
+    bar_widget(&f, 20, 265, LCD_W - 40, 10, tx_pct, COLOR_BG, COLOR_ORANGE);
+    render_end(&f);
 }
 
-void render_page_system(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
-
-    draw_string_centered(20, g_metrics.hostname, COLOR_CYAN, 2);
+static void system_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 20, g_metrics.hostname, COLOR_CYAN, 2);
+    draw_rounded_rect(s, 10, 60, LCD_W - 20, 70, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 68, "UPTIME", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 10, 145, LCD_W - 20, 70, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 153, "LOAD", COLOR_DARK_GRAY, 1);
+}
 
-    draw_rounded_rect(10, 60, LCD_W - 20, 70, 8, COLOR_BG_CARD);
-    draw_string(20, 68, "UPTIME", COLOR_DARK_GRAY, 1);
+void render_page_system(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_SYSTEM, system_static, g_metrics.hostname);
 
     char buf[64];
     int days = g_metrics.uptime_secs / 86400;
@@ -442,102 +1311,109 @@ void render_page_system(void) {
         int mins = (g_metrics.uptime_secs % 3600) / 60;
         snprintf(buf, sizeof(buf), "%dh %dm", hours, mins);
     }
-    draw_string(20, 90, buf, COLOR_GREEN, 3);
+    text_widget(&f, 20, 90, buf, COLOR_GREEN, 3);
 
-    draw_rounded_rect(10, 145, LCD_W - 20, 70, 8, COLOR_BG_CARD);
-    draw_string(20, 153, "LOAD", COLOR_DARK_GRAY, 1);
     snprintf(buf, sizeof(buf), "%.1f %.1f %.1f",
              g_metrics.load_1, g_metrics.load_5, g_metrics.load_15);
-    draw_string(20, 175, buf, COLOR_WHITE, 3);
+    text_widget(&f, 20, 175, buf, COLOR_WHITE, 3);
 
+    char date[32] = "";
+    buf[0] = '\0';
     time_t now = time(NULL);
     struct tm tm_buf;
     struct tm *tm = localtime_r(&now, &tm_buf);
     if (tm) {
         snprintf(buf, sizeof(buf), "%02d:%02d", tm->tm_hour, tm->tm_min);
-        draw_string_centered(240, buf, COLOR_WHITE, 5);
-        strftime(buf, sizeof(buf), "%d.%m.%Y", tm);
-        draw_string_centered(300, buf, COLOR_DARK_GRAY, 1);
+        strftime(date, sizeof(date), "%d.%m.%Y", tm);
     }
+    text_widget_centered(&f, 240, buf, COLOR_WHITE, 5);
+    text_widget_centered(&f, 300, date, COLOR_DARK_GRAY, 1);
+    render_end(&f);
+}
+
+static void overview_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_rounded_rect(s, 10, 10, LCD_W - 20, 85, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 18, "CPU", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 10, 105, LCD_W - 20, 85, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 113, "MEM", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 10, 200, 107, 55, 6, COLOR_BG_CARD);
+    draw_string(s, 18, 208, "TEMP", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 123, 200, 107, 55, 6, COLOR_BG_CARD);
+    draw_string(s, 131, 208, "LOAD", COLOR_DARK_GRAY, 1);
 }
 
-void render_page_overview(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
+void render_page_overview(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_OVERVIEW, overview_static, "");
 
-    draw_rounded_rect(10, 10, LCD_W - 20, 85, 8, COLOR_BG_CARD);
-    draw_string(20, 18, "CPU", COLOR_DARK_GRAY, 1);
     char buf[32];
     snprintf(buf, sizeof(buf), "%.0f%%", g_metrics.cpu_usage);
-    draw_string(20, 40, buf, COLOR_CYAN, 4);
-    draw_progress_bar(20, 80, LCD_W - 40, 10, g_metrics.cpu_usage, COLOR_BG, COLOR_CYAN);
+    text_widget(&f, 20, 40, buf, COLOR_CYAN, 4);
+    bar_widget(&f, 20, 80, LCD_W - 40, 10, g_metrics.cpu_usage, COLOR_BG, COLOR_CYAN);
 
-    draw_rounded_rect(10, 105, LCD_W - 20, 85, 8, COLOR_BG_CARD);
-    draw_string(20, 113, "MEM", COLOR_DARK_GRAY, 1);
     snprintf(buf, sizeof(buf), "%.0f%%", g_metrics.mem_pct);
-    draw_string(20, 135, buf, COLOR_BLUE, 4);
-    draw_progress_bar(20, 175, LCD_W - 40, 10, g_metrics.mem_pct, COLOR_BG, COLOR_BLUE);
+    text_widget(&f, 20, 135, buf, COLOR_BLUE, 4);
+    bar_widget(&f, 20, 175, LCD_W - 40, 10, g_metrics.mem_pct, COLOR_BG, COLOR_BLUE);
 
-    draw_rounded_rect(10, 200, 107, 55, 6, COLOR_BG_CARD);
-    draw_string(18, 208, "TEMP", COLOR_DARK_GRAY, 1);
     if (g_metrics.cpu_temp > 0) {
         snprintf(buf, sizeof(buf), "%.0fC", g_metrics.cpu_temp);
         uint16_t tc = (g_metrics.cpu_temp > 80) ? COLOR_RED : COLOR_ORANGE;
-        draw_string(18, 228, buf, tc, 2);
+        text_widget(&f, 18, 228, buf, tc, 2);
     } else {
-        draw_string(18, 228, "--", COLOR_GRAY, 2);
+        text_widget(&f, 18, 228, "--", COLOR_GRAY, 2);
     }
 
-    draw_rounded_rect(123, 200, 107, 55, 6, COLOR_BG_CARD);
-    draw_string(131, 208, "LOAD", COLOR_DARK_GRAY, 1);
     snprintf(buf, sizeof(buf), "%.1f", g_metrics.load_1);
-    draw_string(131, 228, buf, COLOR_GREEN, 2);
+    text_widget(&f, 131, 228, buf, COLOR_GREEN, 2);
 
+    buf[0] = '\0';
     time_t now = time(NULL);
     struct tm tm_buf;
     struct tm *tm = localtime_r(&now, &tm_buf);
     if (tm) {
         snprintf(buf, sizeof(buf), "%02d:%02d", tm->tm_hour, tm->tm_min);
-        draw_string_centered(270, buf, COLOR_WHITE, 4);
     }
+    text_widget_centered(&f, 270, buf, COLOR_WHITE, 4);
+    render_end(&f);
 }
 
 /* ========== Proxmox Page Renderers ========== */
 
-void render_page_proxmox(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
+static void proxmox_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 10, "PROXMOX", COLOR_CYAN, 2);
+    draw_rounded_rect(s, 10, 50, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 58, "VMs", COLOR_DARK_GRAY, 1);
+    draw_rounded_rect(s, 10, 155, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+    draw_string(s, 20, 163, "CTs", COLOR_DARK_GRAY, 1);
+    draw_string_centered(s, 265, g_pve_metrics.node_name, COLOR_GRAY, 2);
+}
 
-    draw_string_centered(10, "PROXMOX", COLOR_CYAN, 2);
+void render_page_proxmox(Surface *s) {
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_PROXMOX, proxmox_static, g_pve_metrics.node_name);
 
     /* VM card */
-    draw_rounded_rect(10, 50, LCD_W - 20, 90, 8, COLOR_BG_CARD);
-    draw_string(20, 58, "VMs", COLOR_DARK_GRAY, 1);
-
     char buf[64];
     snprintf(buf, sizeof(buf), "%d", g_pve_metrics.running_vms);
-    draw_string(20, 78, buf, COLOR_GREEN, 4);
+    text_widget(&f, 20, 78, buf, COLOR_GREEN, 4);
     int num_w = string_width(buf, 4);
     snprintf(buf, sizeof(buf), "/ %d", g_pve_metrics.total_vms);
-    draw_string(20 + num_w + 4, 88, buf, COLOR_GRAY, 2);
+    text_widget(&f, 20 + num_w + 4, 88, buf, COLOR_GRAY, 2);
 
     /* CT card */
-    draw_rounded_rect(10, 155, LCD_W - 20, 90, 8, COLOR_BG_CARD);
-    draw_string(20, 163, "CTs", COLOR_DARK_GRAY, 1);
-
     snprintf(buf, sizeof(buf), "%d", g_pve_metrics.running_cts);
-    draw_string(20, 183, buf, COLOR_GREEN, 4);
+    text_widget(&f, 20, 183, buf, COLOR_GREEN, 4);
     num_w = string_width(buf, 4);
     snprintf(buf, sizeof(buf), "/ %d", g_pve_metrics.total_cts);
-    draw_string(20 + num_w + 4, 193, buf, COLOR_GRAY, 2);
-
-    /* Node name */
-    draw_string_centered(265, g_pve_metrics.node_name, COLOR_GRAY, 2);
+    text_widget(&f, 20 + num_w + 4, 193, buf, COLOR_GRAY, 2);
 
     /* PVE version at bottom */
-    if (g_pve_metrics.pve_version[0] != '\0') {
-        char ver[30];
-        snprintf(ver, sizeof(ver), "%.29s", g_pve_metrics.pve_version);
-        draw_string_centered(298, ver, COLOR_DARK_GRAY, 1);
-    }
+    char ver[30];
+    snprintf(ver, sizeof(ver), "%.29s", g_pve_metrics.pve_version);
+    text_widget_centered(&f, 298, ver, COLOR_DARK_GRAY, 1);
+    render_end(&f);
 }
 
 static void format_bytes_human(uint64_t bytes, char *buf, size_t len) {
@@ -552,19 +1428,27 @@ static void format_bytes_human(uint64_t bytes, char *buf, size_t len) {
     }
 }
 
-void render_page_storage(void) {
-    fill_rect(0, 0, LCD_W, LCD_H, COLOR_BG);
-
-    draw_string_centered(10, "STORAGE", COLOR_WHITE, 2);
+static void storage_static(Surface *s) {
+    fill_rect(s, 0, 0, LCD_W, LCD_H, COLOR_BG);
+    draw_string_centered(s, 10, "STORAGE", COLOR_WHITE, 2);
+    if (g_pve_metrics.storage_count == 0) {
+        draw_string_centered(s, 140, "No storage", COLOR_DARK_GRAY, 2);
+        draw_string_centered(s, 170, "detected", COLOR_DARK_GRAY, 2);
+    }
+}
 
+void render_page_storage(Surface *s) {
     int max_display = g_pve_metrics.storage_count;
     if (max_display > 4) max_display = 4;
 
+    RenderFrame f;
+    render_begin(&f, s, LAYOUT_STORAGE + max_display, storage_static, "");
+
     for (int i = 0; i < max_display; i++) {
         int y_base = 45 + i * 68;
 
         /* Pool name */
-        draw_string(10, y_base, g_pve_metrics.storage[i].name, COLOR_CYAN, 1);
+        text_widget(&f, 10, y_base, g_pve_metrics.storage[i].name, COLOR_CYAN, 1);
 
         /* Usage color based on percentage */
         uint16_t bar_color;
@@ -577,7 +1461,7 @@ void render_page_storage(void) {
             bar_color = COLOR_GREEN;
 
         /* Progress bar */
-        draw_progress_bar(10, y_base + 18, LCD_W - 20, 12, pct, COLOR_BG_GAUGE, bar_color);
+        bar_widget(&f, 10, y_base + 18, LCD_W - 20, 12, pct, COLOR_BG_GAUGE, bar_color);
 
         /* Usage text */
         char used_str[16], total_str[16], pct_str[8];
@@ -587,15 +1471,11 @@ void render_page_storage(void) {
 
         char info[48];
         snprintf(info, sizeof(info), "%s / %s", used_str, total_str);
-        draw_string(10, y_base + 36, info, COLOR_GRAY, 1);
+        text_widget(&f, 10, y_base + 36, info, COLOR_GRAY, 1);
 
         /* Percentage on the right */
         int pct_w = string_width(pct_str, 2);
-        draw_string(LCD_W - 10 - pct_w, y_base + 32, pct_str, bar_color, 2);
-    }
-
-    if (max_display == 0) {
-        draw_string_centered(140, "No storage", COLOR_DARK_GRAY, 2);
-        draw_string_centered(170, "detected", COLOR_DARK_GRAY, 2);
+        text_widget(&f, LCD_W - 10 - pct_w, y_base + 32, pct_str, bar_color, 2);
     }
+    render_end(&f);
 }
@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ * Copyright (C) 2026 homelab-screen contributors
+ */
+
+#include "trlcd.h"
+
+/*
+ * Write w x h little-endian RGB565 pixels as a binary PPM (P6). Channels
+ * are widened by repeating their top bits, so white stays 255.
+ */
+int write_ppm(const char *path, const uint16_t *px, int w, int h) {
+    uint8_t *row = malloc((size_t)w * 3);
+    if (!row) {
+        errno = ENOMEM;
+        return -1;
+    }
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        free(row);
+        return -1;
+    }
+
+    int ok = fprintf(f, "P6\n%d %d\n255\n", w, h) > 0;
+    for (int y = 0; y < h && ok; y++) {
+        for (int x = 0; x < w; x++) {
+            uint16_t c = le16toh(px[y * w + x]);
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            row[3 * x] = (uint8_t)(r << 3 | r >> 2);
+            row[3 * x + 1] = (uint8_t)(g << 2 | g >> 4);
+            row[3 * x + 2] = (uint8_t)(b << 3 | b >> 2);
+        }
+        ok = fwrite(row, 3, (size_t)w, f) == (size_t)w;
+    }
+    free(row);
+    if (fclose(f) != 0 || !ok) {
+        return -1;
+    }
+    return 0;
+}
+
+static double snapshot_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_render_rate(uint64_t frames, double secs) {
+    printf("Rendered %" PRIu64 " frames in %.3f s of drawing: %.1f fps\n",
+           frames, secs, secs > 0 ? frames / secs : 0.0);
+    fflush(stdout);
+}
+
+/*
+ * Headless mode (--render-to): no USB. Every tick the metrics are collected
+ * and every page is drawn into its own offscreen frame, so pages repaint
+ * incrementally as on a panel, then written to dir/<name>.ppm. The rate
+ * counts drawing time only, leaving out encoding and the tick pause; it is
+ * printed on SIGUSR1 and on exit. With once set a single tick is drawn.
+ */
+int render_to_dir(const char *dir, void (*const renderers[])(Surface *s), const char *const names[],
+                  int num_pages, int once) {
+    size_t pixel_size = g_palette_mode ? 1 : sizeof(uint16_t);
+    uint8_t *frames = malloc((size_t)num_pages * LCD_W * LCD_H * pixel_size);
+    uint16_t *rgb = malloc(FRAME_SIZE);
+    if (!frames || !rgb) {
+        fprintf(stderr, "Out of memory for headless frames\n");
+        free(frames);
+        free(rgb);
+        return 1;
+    }
+
+    printf("Rendering %d pages to %s\n", num_pages, dir);
+    uint64_t rendered = 0;
+    double render_s = 0;
+    int rc = 0;
+    while (g_running && rc == 0) {
+        collect_and_publish();
+        metrics_update();
+
+        for (int p = 0; p < num_pages && rc == 0; p++) {
+            uint8_t *mem = frames + (size_t)p * LCD_W * LCD_H * pixel_size;
+            Surface s = g_palette_mode ? surface_wrap_indexed(mem, LCD_W, LCD_H, LCD_W)
+                                       : surface_wrap((uint16_t *)mem, LCD_W, LCD_H, LCD_W);
+            double start = snapshot_now_s();
+            renderers[p](&s);
+            render_s += snapshot_now_s() - start;
+            rendered++;
+
+            if (s.idx) {
+                surface_expand(rgb, &s);
+            }
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s.ppm", dir, names[p]);
+            if (write_ppm(path, s.idx ? rgb : s.px, LCD_W, LCD_H) != 0) {
+                fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+                rc = 1;
+            }
+        }
+
+        if (g_stats_requested) {
+            g_stats_requested = 0;
+            print_render_rate(rendered, render_s);
+        }
+        if (once) {
+            break;
+        }
+        struct timespec ts = {0, 100000000}; /* 100ms, as on a panel */
+        nanosleep(&ts, NULL);
+    }
+
+    print_render_rate(rendered, render_s);
+    render_release(frames, (size_t)num_pages * LCD_W * LCD_H * pixel_size);
+    metrics_close();
+    free(frames);
+    free(rgb);
+    return rc;
+}
@@ -9,11 +9,19 @@ uint16_t g_vid = 0x0416;
 uint16_t g_pid = 0x5302;
 int g_interval = 7;
 char g_cli_iface[32] = "";
+int g_chunk_size = TRANSFER_SIZE;
+int g_keepalive = 5;
+int g_palette_mode = 0;
+char g_render_dir[256] = "";
+int g_snapshot = 0;
+PanelConfig g_panel_cfg[MAX_PANELS];
+int g_num_panels = 0;
 
-uint16_t framebuffer[LCD_W * LCD_H];
 volatile sig_atomic_t g_running = 1;
+volatile sig_atomic_t g_stats_requested = 0;
 
 Metrics g_metrics;
+Metrics g_sample;
 uint64_t last_net_rx = 0;
 uint64_t last_net_tx = 0;
 time_t last_net_time = 0;
@@ -21,13 +29,13 @@ uint64_t last_cpu_idle = 0;
 uint64_t last_cpu_total = 0;
 
 ProxmoxMetrics g_pve_metrics;
+ProxmoxMetrics g_pve_sample;
 time_t last_pve_collect = 0;
 
-libusb_device_handle *dev_handle = NULL;
-unsigned char g_ep_out = 0x02;
-int g_usb_iface = -1;
-
 void signal_handler(int sig) {
-    (void)sig;
+    if (sig == SIGUSR1) {
+        g_stats_requested = 1;
+        return;
+    }
     g_running = 0;
 }
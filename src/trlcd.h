@@ -7,12 +7,16 @@
 #define TRLCD_H
 
 #include <dirent.h>
+#include <endian.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,6 +34,9 @@
 #define LCD_H 320
 #define FRAME_SIZE (LCD_W * LCD_H * 2)
 #define PACKET_SIZE 512
+#define TRANSFER_SIZE (PACKET_SIZE + FRAME_SIZE) /* header packet + pixel payload */
+#define MAX_PANELS 4
+#define MAX_CORES 256 /* per-core usage beyond this is not shown */
 
 typedef struct {
     char hostname[64];
@@ -45,6 +52,8 @@ typedef struct {
     float net_rx_rate;
     float net_tx_rate;
     char net_iface[32];
+    int core_count;              /* cpuN lines seen: highest N + 1 */
+    uint8_t core_pct[MAX_CORES]; /* per-core usage, 0-100 */
 } Metrics;
 
 typedef struct {
@@ -64,15 +73,55 @@ typedef struct {
     int storage_count;
 } ProxmoxMetrics;
 
+/* Screen-space rectangle; empty when w or h is 0. */
+typedef struct {
+    int x, y, w, h;
+} Rect;
+
+/*
+ * Drawing target: w x h little-endian RGB565 pixels at px, rows stride
+ * pixels apart, or with --palette 8-bit palette indices at idx (px NULL).
+ * Primitives draw only inside clip.
+ */
+typedef struct {
+    uint16_t *px;
+    uint8_t *idx;
+    int w, h;
+    int stride;
+    Rect clip;
+} Surface;
+
+/* One --device entry; bus/addr of -1 match any device with the IDs. */
+typedef struct {
+    uint16_t vid;
+    uint16_t pid;
+    int bus;
+    int addr;
+} PanelConfig;
+
 extern uint16_t g_vid;
 extern uint16_t g_pid;
 extern int g_interval;
 extern char g_cli_iface[32];
-
-extern uint16_t framebuffer[LCD_W * LCD_H];
+extern int g_chunk_size;
+extern int g_keepalive;
+extern int g_palette_mode;
+extern char g_render_dir[256];
+extern int g_snapshot;
+extern PanelConfig g_panel_cfg[MAX_PANELS];
+extern int g_num_panels;
+
+extern uint16_t *framebuffer; /* little-endian RGB565, owned by usb.c */
 extern volatile sig_atomic_t g_running;
+extern volatile sig_atomic_t g_stats_requested; /* set by SIGUSR1 */
 
+/*
+ * The collectors fill g_sample and g_pve_sample and publish them as one
+ * snapshot; pages draw from g_metrics and g_pve_metrics, which the render
+ * loop refreshes from the newest snapshot.
+ */
 extern Metrics g_metrics;
+extern Metrics g_sample;
 extern uint64_t last_net_rx;
 extern uint64_t last_net_tx;
 extern time_t last_net_time;
@@ -80,32 +129,61 @@ extern uint64_t last_cpu_idle;
 extern uint64_t last_cpu_total;
 
 extern ProxmoxMetrics g_pve_metrics;
+extern ProxmoxMetrics g_pve_sample;
 extern time_t last_pve_collect;
 
-extern libusb_device_handle *dev_handle;
-extern unsigned char g_ep_out;
-extern int g_usb_iface;
-
 void signal_handler(int sig);
 
 void detect_network_interface(void);
 void get_hostname(char *buf, size_t len);
 void collect_metrics(void);
+void metrics_close(void);
 
 void check_pve_available(void);
 void collect_proxmox_metrics(void);
 
-void render_page_overview(void);
-void render_page_cpu(void);
-void render_page_memory(void);
-void render_page_network(void);
-void render_page_system(void);
-void render_page_proxmox(void);
-void render_page_storage(void);
+void metrics_publish(void);
+int metrics_update(void);
+void collect_and_publish(void);
+int collector_start(void);
+void collector_stop(void);
+
+const char *pixel_kernels_name(void);
+void pixel_fill16(uint16_t *dst, uint16_t value, size_t n);
+uint64_t pixel_hash64(const void *data, size_t len);
+void pixel_expand8(uint16_t *dst, const uint8_t *src, const uint16_t *lut, int lut_size, size_t n);
+
+Surface surface_wrap(uint16_t *px, int w, int h, int stride);
+Surface surface_wrap_indexed(uint8_t *idx, int w, int h, int stride);
+void surface_expand(uint16_t *dst, const Surface *s);
+void render_page_overview(Surface *s);
+void render_page_cpu(Surface *s);
+void render_page_memory(Surface *s);
+void render_page_network(Surface *s);
+void render_page_system(Surface *s);
+void render_page_cores(Surface *s);
+void render_page_proxmox(Surface *s);
+void render_page_storage(Surface *s);
+/*
+ * Pages remember what they drew into each surface, keyed by its memory,
+ * and may seed a new frame by copying from another one. Memory a page was
+ * rendered into must be passed to render_release() before it is freed or
+ * put to other use.
+ */
+void render_release(const void *mem, size_t len);
+Rect render_damage(const Surface *s);
+
+int write_ppm(const char *path, const uint16_t *px, int w, int h);
+int render_to_dir(const char *dir, void (*const renderers[])(Surface *s), const char *const names[],
+                  int num_pages, int once);
 
 int usb_init(void);
 void usb_cleanup(void);
+int usb_panel_count(void);
+void usb_select_panel(int panel);
 int send_frame(void);
+int send_unchanged_frame(void);
+void usb_report_stats(int requested);
 
 int parse_args(int argc, char **argv);
 
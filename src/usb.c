@@ -5,29 +5,556 @@
 
 #include "trlcd.h"
 
-int usb_init(void) {
-    struct libusb_config_descriptor *cfg = NULL;
-    int rc = libusb_init(NULL);
+#define USB_SLOTS 2
+#define USB_TIMEOUT_MS 1000 /* slack on top of the expected wire time */
+#define USB_RETRY_MIN_MS 250
+#define USB_RETRY_MAX_MS 4000
+#define USB_STATS_PERIOD_S 300
+#define USB_LAT_BUCKETS 24 /* bucket b: [2^b, 2^(b+1)) us, the last one open-ended */
+
+struct UsbPanel;
+
+/*
+ * One in-flight frame: the header packet followed by the RGB565 payload,
+ * streamed to the device in chunks of the panel's chunk size by
+ * resubmitting the same transfer from its completion callback. With the
+ * default chunk size the whole frame is a single submission and the kernel
+ * does the packet splitting. The payload doubles as the render target, so
+ * pixels are stored in device (little-endian) order and sent without a copy.
+ * While a device is open the buffer is usbfs memory mapped from the kernel,
+ * so the controller reads the frame where it was drawn and usbfs skips its
+ * own copy of every submission; otherwise it is a page-aligned heap buffer.
+ */
+typedef struct {
+    uint16_t *buf;  /* dma when mapped, else heap */
+    uint16_t *heap; /* page-aligned fallback, held from usb_init to usb_cleanup */
+    uint16_t *dma;  /* libusb_dev_mem_alloc memory of the open handle, or NULL */
+    struct libusb_transfer *xfer;
+    struct UsbPanel *panel;
+    int offset;     /* bytes of buf already acknowledged by the device */
+    int busy;       /* guarded by g_usb_lock */
+
+    /* Per-frame accounting, owned by whichever thread drives the slot */
+    struct timespec submitted;
+    uint64_t bytes;
+    int retries;
+    int short_write;
+} FrameSlot;
+
+/*
+ * Transfer statistics, guarded by g_usb_lock. Fixed log2 buckets keep
+ * recording allocation-free on the event thread; percentiles are reported
+ * as the upper bound of the bucket they fall in.
+ */
+typedef struct {
+    uint64_t hist[USB_LAT_BUCKETS];
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t bytes;
+    uint64_t retries;
+    uint64_t short_writes;
+    uint64_t max_us;
+} UsbStats;
+
+/* Per-LCD context: device handle, transfer slots, reconnect and skip state. */
+typedef struct UsbPanel {
+    PanelConfig cfg;
+    libusb_device_handle *handle;
+    unsigned char ep_out;
+    int iface;
+    int bus, addr;      /* of the opened device, for @bus:addr matching */
+    int speed;          /* enum libusb_speed of the link */
+    int max_packet;     /* endpoint wMaxPacketSize */
+    int unit;           /* smallest submission, a whole number of packets */
+    unsigned timeout_ms;
+
+    FrameSlot slots[USB_SLOTS];
+    int next_slot;
+    int failed;         /* guarded by g_usb_lock */
+    int halted;         /* endpoint stalled, guarded by g_usb_lock */
+    atomic_int chunk;   /* active chunk size, may drop to unit */
+
+    /* Device loss and re-open, main thread only unless noted */
+    int hotplug_registered;
+    libusb_hotplug_callback_handle hotplug;
+    atomic_int arrived; /* set by the hotplug callback */
+    struct timespec last_attempt;
+    long retry_ms;
+
+    /* Unchanged-frame suppression, main thread only */
+    int have_last_hash;
+    uint64_t last_hash;
+    int have_queued_hash;
+    uint64_t queued_hash; /* of the frame last passed to send_frame */
+    struct timespec last_sent;
+    uint64_t frames_sent;
+    uint64_t frames_skipped;
+
+    UsbStats stats;
+} UsbPanel;
+
+static UsbPanel g_panels[MAX_PANELS];
+static int g_panel_count = 0;
+static UsbPanel *g_panel = &g_panels[0]; /* target of render and send_frame */
+
+/* Back buffer: payload of the selected panel's slot the next frame goes into. */
+uint16_t *framebuffer = NULL;
+
+/* Shared by all panels: one lock for slot state, one libusb event thread. */
+static pthread_mutex_t g_usb_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_usb_idle = PTHREAD_COND_INITIALIZER;
+static pthread_t g_usb_thread;
+static int g_usb_thread_running = 0;
+static atomic_int g_usb_thread_stop;
+static struct timespec g_stats_printed;
+
+static void build_header(uint8_t hdr[PACKET_SIZE]) {
+    memset(hdr, 0, PACKET_SIZE);
+    hdr[0] = 0xDA; hdr[1] = 0xDB; hdr[2] = 0xDC; hdr[3] = 0xDD; /* magic */
+    hdr[4] = 0x02; hdr[5] = 0x00;   /* ver=2 */
+    hdr[6] = 0x01; hdr[7] = 0x00;   /* cmd=1 */
+    hdr[8] = 0xF0; hdr[9] = 0x00;   /* H=240 */
+    hdr[10] = 0x40; hdr[11] = 0x01; /* W=320 */
+    hdr[12] = 0x02; hdr[13] = 0x00; /* fmt=2 (RGB565) */
+    hdr[22] = 0x00; hdr[23] = 0x58; hdr[24] = 0x02; hdr[25] = 0x00; /* frame_len = 0x00025800 */
+    hdr[26] = 0x00; hdr[27] = 0x00; hdr[28] = 0x00; hdr[29] = 0x08; /* extra */
+}
+
+/*
+ * Point the slot at mem and stamp the header; the payload is drawn later.
+ * The renderer keys retained frames by buffer address, so the memory the
+ * slot leaves is released and the new one starts over.
+ */
+static void slot_attach(FrameSlot *slot, uint16_t *mem) {
+    if (slot->buf) {
+        render_release(slot->buf, TRANSFER_SIZE);
+    }
+    slot->buf = mem;
+    build_header((uint8_t *)mem);
+}
+
+/* Payload of the slot the panel's next frame is rendered into. */
+static uint16_t *panel_back_buffer(UsbPanel *p) {
+    return p->slots[p->next_slot].buf + PACKET_SIZE / 2;
+}
+
+/*
+ * Heap buffers back the slots whenever no usbfs memory is mapped, so the
+ * render target stays valid while a panel is unplugged.
+ */
+static int usb_alloc_buffers(UsbPanel *p) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (int s = 0; s < USB_SLOTS; s++) {
+        FrameSlot *slot = &p->slots[s];
+        void *mem = NULL;
+        if (posix_memalign(&mem, page, TRANSFER_SIZE) != 0) {
+            fprintf(stderr, "Failed to allocate frame buffers\n");
+            return -1;
+        }
+        slot->heap = mem;
+        slot->dma = NULL;
+        slot_attach(slot, slot->heap);
+    }
+    return 0;
+}
+
+static void usb_free_buffers(UsbPanel *p) {
+    for (int s = 0; s < USB_SLOTS; s++) {
+        if (p->slots[s].buf) {
+            render_release(p->slots[s].buf, TRANSFER_SIZE);
+        }
+        free(p->slots[s].heap);
+        p->slots[s].heap = NULL;
+        p->slots[s].buf = NULL;
+    }
+}
+
+/*
+ * Move the slots into usbfs memory of the freshly opened handle. Mapped
+ * memory belongs to the handle, so the payload is carried over in both
+ * directions and a frame drawn across a reconnect is not lost. Kernels
+ * without usbfs mmap leave the slots on the heap.
+ */
+static void usb_map_buffers(UsbPanel *p) {
+    for (int s = 0; s < USB_SLOTS; s++) {
+        FrameSlot *slot = &p->slots[s];
+        unsigned char *mem = libusb_dev_mem_alloc(p->handle, TRANSFER_SIZE);
+        if (!mem) break;
+        memcpy(mem + PACKET_SIZE, (uint8_t *)slot->buf + PACKET_SIZE, FRAME_SIZE);
+        slot->dma = (uint16_t *)mem;
+        slot_attach(slot, slot->dma);
+    }
+}
+
+/* Back to the heap before the handle that owns the mapping is closed. */
+static void usb_unmap_buffers(UsbPanel *p) {
+    for (int s = 0; s < USB_SLOTS; s++) {
+        FrameSlot *slot = &p->slots[s];
+        if (slot->dma) {
+            memcpy((uint8_t *)slot->heap + PACKET_SIZE, (uint8_t *)slot->dma + PACKET_SIZE, FRAME_SIZE);
+            libusb_dev_mem_free(p->handle, (unsigned char *)slot->dma, TRANSFER_SIZE);
+            slot->dma = NULL;
+            slot_attach(slot, slot->heap);
+        }
+    }
+}
+
+static int64_t elapsed_us(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - since->tv_sec) * 1000000 + (now.tv_nsec - since->tv_nsec) / 1000;
+}
+
+static long elapsed_ms(const struct timespec *since) {
+    return (long)(elapsed_us(since) / 1000);
+}
+
+static const char *transfer_status_name(enum libusb_transfer_status status) {
+    static const char *names[] = {
+        "COMPLETED", "ERROR", "TIMED_OUT", "CANCELLED", "STALL", "NO_DEVICE", "OVERFLOW"
+    };
+    return ((unsigned)status < sizeof(names) / sizeof(names[0])) ? names[status] : "UNKNOWN";
+}
+
+static const char *usb_speed_name(int speed) {
+    switch (speed) {
+    case LIBUSB_SPEED_LOW: return "low";
+    case LIBUSB_SPEED_FULL: return "full";
+    case LIBUSB_SPEED_HIGH: return "high";
+    case LIBUSB_SPEED_SUPER: return "super";
+    case LIBUSB_SPEED_SUPER_PLUS: return "super+";
+    default: return "unknown";
+    }
+}
+
+/* Sustained bulk throughput we plan timeouts with, in bytes per ms. */
+static int usb_speed_bytes_per_ms(int speed) {
+    switch (speed) {
+    case LIBUSB_SPEED_HIGH: return 30000;
+    case LIBUSB_SPEED_SUPER: return 300000;
+    case LIBUSB_SPEED_SUPER_PLUS: return 600000;
+    default: return 800; /* full speed, or unknown: assume the slowest bulk link */
+    }
+}
+
+/*
+ * Pick chunking and timeout from the endpoint and link. Every submission
+ * but the last must be a whole number of wMaxPacketSize packets, or the
+ * device would see a short packet and end the frame early, so the fallback
+ * unit is the larger of the protocol packet and the endpoint packet, and
+ * --chunk-size is rounded up to it. The timeout covers the expected wire
+ * time of one submission twice over, so whole-frame transfers on a
+ * full-speed hub do not time out while high-speed failures surface fast.
+ */
+static void usb_plan_transfers(UsbPanel *p) {
+    p->unit = p->max_packet > PACKET_SIZE ? p->max_packet : PACKET_SIZE;
+    int chunk = (g_chunk_size + p->unit - 1) / p->unit * p->unit;
+    if (chunk > TRANSFER_SIZE) chunk = TRANSFER_SIZE;
+    atomic_store(&p->chunk, chunk);
+    p->timeout_ms = USB_TIMEOUT_MS + 2u * (unsigned)(chunk / usb_speed_bytes_per_ms(p->speed));
+}
+
+static void frame_transfer_cb(struct libusb_transfer *xfer);
+
+static int submit_chunk(FrameSlot *slot) {
+    UsbPanel *p = slot->panel;
+    int chunk = atomic_load(&p->chunk);
+    int len = TRANSFER_SIZE - slot->offset;
+    if (len > chunk) len = chunk;
+
+    libusb_fill_bulk_transfer(slot->xfer, p->handle, p->ep_out,
+                              (unsigned char *)slot->buf + slot->offset, len,
+                              frame_transfer_cb, slot, p->timeout_ms);
+    int rc = libusb_submit_transfer(slot->xfer);
     if (rc < 0) {
-        fprintf(stderr, "Failed to init libusb\n");
+        fprintf(stderr, "USB %s submit failed: %s\n",
+                slot->offset == 0 ? "header" : "data", libusb_error_name(rc));
+    }
+    return rc;
+}
+
+/*
+ * Some devices and host controllers refuse large bulk submissions. Drop to
+ * one unit-sized chunk per submission for the rest of the session; returns
+ * -1 when already there.
+ */
+static int drop_to_packets(UsbPanel *p, const char *reason) {
+    int chunk = atomic_load(&p->chunk);
+    if (chunk <= p->unit) {
         return -1;
     }
+    fprintf(stderr, "USB %d-byte transfers rejected (%s), falling back to %d-byte packets\n",
+            chunk, reason, p->unit);
+    atomic_store(&p->chunk, p->unit);
+    return 0;
+}
 
-    dev_handle = libusb_open_device_with_vid_pid(NULL, g_vid, g_pid);
-    if (!dev_handle) {
-        fprintf(stderr, "Device not found (VID:%04X PID:%04X)\n", g_vid, g_pid);
-        libusb_exit(NULL);
+/*
+ * Resubmit a frame whose header chunk never reached the device in packet
+ * mode. Only valid while nothing of the frame has been delivered, since the
+ * device would otherwise see a second header in the middle of the pixels.
+ * Returns 0 when the frame was requeued.
+ */
+static int retry_in_packets(FrameSlot *slot, const char *reason) {
+    if (drop_to_packets(slot->panel, reason) < 0) {
+        return -1;
+    }
+    slot->offset = 0;
+    slot->retries++;
+    return submit_chunk(slot) < 0 ? -1 : 0;
+}
+
+/* libusb refused the submission itself, as opposed to failing it on the bus. */
+static int submit_rejected(int rc) {
+    return rc == LIBUSB_ERROR_INVALID_PARAM || rc == LIBUSB_ERROR_NO_MEM;
+}
+
+static int latency_bucket(uint64_t us) {
+    int b = 63 - __builtin_clzll(us | 1);
+    return b < USB_LAT_BUCKETS ? b : USB_LAT_BUCKETS - 1;
+}
+
+/* Fold the slot's frame into the panel statistics; g_usb_lock held. */
+static void record_frame(UsbStats *st, const FrameSlot *slot, int failed) {
+    st->bytes += slot->bytes;
+    st->retries += (uint64_t)slot->retries;
+    st->short_writes += (uint64_t)slot->short_write;
+    if (failed) {
+        st->failed++;
+        return;
+    }
+    uint64_t us = (uint64_t)elapsed_us(&slot->submitted);
+    st->completed++;
+    st->hist[latency_bucket(us)]++;
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+}
+
+typedef enum {
+    FRAME_DONE,
+    FRAME_FAILED,  /* close the device; the next frame reopens it */
+    FRAME_STALLED, /* clear the endpoint halt before the next frame */
+} FrameResult;
+
+static void finish_slot(FrameSlot *slot, FrameResult result) {
+    pthread_mutex_lock(&g_usb_lock);
+    record_frame(&slot->panel->stats, slot, result != FRAME_DONE);
+    slot->busy = 0;
+    if (result == FRAME_FAILED) {
+        slot->panel->failed = 1;
+    } else if (result == FRAME_STALLED) {
+        slot->panel->halted = 1;
+    }
+    pthread_cond_broadcast(&g_usb_idle);
+    pthread_mutex_unlock(&g_usb_lock);
+}
+
+/*
+ * Runs on the event thread: advance the slot to its next chunk or retire it.
+ * A failure after part of the frame was delivered is never retried in place;
+ * the frame is dropped and the next one starts again from its header.
+ * libusb_clear_halt() blocks on a control transfer, so a stall is only
+ * recorded here and cleared by send_frame() on the render thread.
+ */
+static void frame_transfer_cb(struct libusb_transfer *xfer) {
+    FrameSlot *slot = xfer->user_data;
+    const char *what = slot->offset == 0 ? "header" : "data";
+    int first = slot->offset == 0 && xfer->actual_length == 0;
+
+    slot->bytes += (uint64_t)xfer->actual_length;
+    if (xfer->status == LIBUSB_TRANSFER_STALL) {
+        fprintf(stderr, "USB %s transfer stalled at offset %d\n", what, slot->offset);
+        if (first) {
+            drop_to_packets(slot->panel, "STALL");
+        }
+        finish_slot(slot, FRAME_STALLED);
+        return;
+    }
+    if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+        if (first && xfer->status != LIBUSB_TRANSFER_NO_DEVICE &&
+            retry_in_packets(slot, transfer_status_name(xfer->status)) == 0) {
+            return;
+        }
+        fprintf(stderr, "USB %s transfer failed: %s\n", what, transfer_status_name(xfer->status));
+        finish_slot(slot, FRAME_FAILED);
+        return;
+    }
+    if (xfer->actual_length != xfer->length) {
+        fprintf(stderr, "USB %s transfer short write at offset %d: %d/%d\n",
+                what, slot->offset, xfer->actual_length, xfer->length);
+        slot->short_write = 1;
+        finish_slot(slot, FRAME_FAILED);
+        return;
+    }
+
+    slot->offset += xfer->length;
+    if (slot->offset < TRANSFER_SIZE) {
+        if (submit_chunk(slot) < 0) {
+            finish_slot(slot, FRAME_FAILED);
+        }
+        return;
+    }
+    finish_slot(slot, FRAME_DONE);
+}
+
+static void *usb_event_thread(void *arg) {
+    (void)arg;
+    while (!atomic_load(&g_usb_thread_stop)) {
+        struct timeval tv = {0, 100000};
+        libusb_handle_events_timeout_completed(NULL, &tv, NULL);
+    }
+    return NULL;
+}
+
+static int transport_failed(UsbPanel *p) {
+    pthread_mutex_lock(&g_usb_lock);
+    int failed = p->failed;
+    pthread_mutex_unlock(&g_usb_lock);
+    return failed;
+}
+
+/* Take the stall reported by the event thread, if any. */
+static int transport_halted(UsbPanel *p) {
+    pthread_mutex_lock(&g_usb_lock);
+    int halted = p->halted;
+    p->halted = 0;
+    pthread_mutex_unlock(&g_usb_lock);
+    return halted;
+}
+
+static void wait_slot_idle(FrameSlot *slot) {
+    pthread_mutex_lock(&g_usb_lock);
+    while (slot->busy) {
+        pthread_cond_wait(&g_usb_idle, &g_usb_lock);
+    }
+    pthread_mutex_unlock(&g_usb_lock);
+}
+
+static void wait_transport_idle(UsbPanel *p) {
+    for (int i = 0; i < USB_SLOTS; i++) {
+        wait_slot_idle(&p->slots[i]);
+    }
+}
+
+/* Let in-flight frames finish, then stop the event thread and free transfers. */
+static void usb_transport_stop(void) {
+    if (g_usb_thread_running) {
+        for (int i = 0; i < g_panel_count; i++) {
+            wait_transport_idle(&g_panels[i]);
+        }
+        atomic_store(&g_usb_thread_stop, 1);
+        libusb_interrupt_event_handler(NULL);
+        pthread_join(g_usb_thread, NULL);
+        g_usb_thread_running = 0;
+    }
+    for (int i = 0; i < MAX_PANELS; i++) {
+        for (int s = 0; s < USB_SLOTS; s++) {
+            libusb_free_transfer(g_panels[i].slots[s].xfer);
+            g_panels[i].slots[s].xfer = NULL;
+        }
+    }
+}
+
+static int usb_transport_start(void) {
+    for (int i = 0; i < g_panel_count; i++) {
+        UsbPanel *p = &g_panels[i];
+        for (int s = 0; s < USB_SLOTS; s++) {
+            FrameSlot *slot = &p->slots[s];
+            slot->xfer = libusb_alloc_transfer(0);
+            if (!slot->xfer) {
+                fprintf(stderr, "Failed to allocate USB transfer\n");
+                usb_transport_stop();
+                return -1;
+            }
+            slot->panel = p;
+            slot->offset = 0;
+            slot->busy = 0;
+        }
+        p->next_slot = 0;
+        p->failed = 0;
+        p->halted = 0;
+        p->have_last_hash = 0;
+        p->have_queued_hash = 0;
+        p->frames_sent = 0;
+        p->frames_skipped = 0;
+        memset(&p->stats, 0, sizeof(p->stats));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &g_stats_printed);
+
+    atomic_store(&g_usb_thread_stop, 0);
+    if (pthread_create(&g_usb_thread, NULL, usb_event_thread, NULL) != 0) {
+        fprintf(stderr, "Failed to start USB event thread\n");
+        usb_transport_stop();
+        return -1;
+    }
+    g_usb_thread_running = 1;
+    return 0;
+}
+
+/* Another panel already drives the device at bus:addr. */
+static int usb_device_taken(const UsbPanel *self, int bus, int addr) {
+    for (int i = 0; i < g_panel_count; i++) {
+        const UsbPanel *p = &g_panels[i];
+        if (p != self && p->handle && p->bus == bus && p->addr == addr) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Open the first device matching the panel's VID:PID (and bus:addr when
+ * given) that no other panel has claimed, find its OUT endpoint and claim
+ * the interface. Failures are only reported when report is set so
+ * reconnect polling stays quiet.
+ */
+static int usb_open_device(UsbPanel *p, int report) {
+    struct libusb_config_descriptor *cfg = NULL;
+    libusb_device **list = NULL;
+    libusb_device *found = NULL;
+    int rc;
+
+    ssize_t n = libusb_get_device_list(NULL, &list);
+    for (ssize_t i = 0; i < n; i++) {
+        struct libusb_device_descriptor desc = {0};
+        if (libusb_get_device_descriptor(list[i], &desc) < 0 ||
+            desc.idVendor != p->cfg.vid || desc.idProduct != p->cfg.pid) {
+            continue;
+        }
+        int bus = libusb_get_bus_number(list[i]);
+        int addr = libusb_get_device_address(list[i]);
+        if ((p->cfg.bus >= 0 && (bus != p->cfg.bus || addr != p->cfg.addr)) ||
+            usb_device_taken(p, bus, addr)) {
+            continue;
+        }
+        found = list[i];
+        p->bus = bus;
+        p->addr = addr;
+        break;
+    }
+    rc = found ? libusb_open(found, &p->handle) : LIBUSB_ERROR_NOT_FOUND;
+    if (n >= 0) {
+        libusb_free_device_list(list, 1);
+    }
+    if (rc < 0) {
+        p->handle = NULL;
+        if (report) {
+            fprintf(stderr, "Device not found (VID:%04X PID:%04X)\n", p->cfg.vid, p->cfg.pid);
+        }
         return -1;
     }
 
-    g_ep_out = 0;
-    g_usb_iface = -1;
+    p->ep_out = 0;
+    p->iface = -1;
 
     /* Find OUT endpoint together with its interface number. */
-    libusb_device *dev = libusb_get_device(dev_handle);
+    libusb_device *dev = libusb_get_device(p->handle);
     rc = libusb_get_active_config_descriptor(dev, &cfg);
     if (rc < 0 || !cfg) {
-        fprintf(stderr, "Failed to read USB configuration: %s\n", libusb_error_name(rc));
+        if (report) {
+            fprintf(stderr, "Failed to read USB configuration: %s\n", libusb_error_name(rc));
+        }
         goto fail;
     }
 
@@ -38,8 +565,9 @@ int usb_init(void) {
             for (int e = 0; e < alt->bNumEndpoints; e++) {
                 const struct libusb_endpoint_descriptor *ep = &alt->endpoint[e];
                 if ((ep->bEndpointAddress & 0x80) == 0) { /* OUT endpoint */
-                    g_ep_out = ep->bEndpointAddress;
-                    g_usb_iface = alt->bInterfaceNumber;
+                    p->ep_out = ep->bEndpointAddress;
+                    p->iface = alt->bInterfaceNumber;
+                    p->max_packet = ep->wMaxPacketSize & 0x7FF; /* drop high-bandwidth bits */
                     goto endpoint_found;
                 }
             }
@@ -52,113 +580,347 @@ endpoint_found:
         cfg = NULL;
     }
 
-    if (g_ep_out == 0 || g_usb_iface < 0) {
-        fprintf(stderr, "No usable USB OUT endpoint found.\n");
+    if (p->ep_out == 0 || p->iface < 0) {
+        if (report) {
+            fprintf(stderr, "No usable USB OUT endpoint found.\n");
+        }
         goto fail;
     }
 
-    rc = libusb_set_auto_detach_kernel_driver(dev_handle, 1);
-    if (rc < 0) {
+    rc = libusb_set_auto_detach_kernel_driver(p->handle, 1);
+    if (rc < 0 && report) {
         fprintf(stderr, "Warning: could not auto-detach kernel driver: %s\n", libusb_error_name(rc));
     }
 
-    rc = libusb_claim_interface(dev_handle, g_usb_iface);
+    rc = libusb_claim_interface(p->handle, p->iface);
     if (rc < 0) {
-        fprintf(stderr, "Failed to claim interface %d: %s\n", g_usb_iface, libusb_error_name(rc));
+        if (report) {
+            fprintf(stderr, "Failed to claim interface %d: %s\n", p->iface, libusb_error_name(rc));
+        }
         goto fail;
     }
 
-    printf("Found OUT endpoint: 0x%02X on interface %d\n", g_ep_out, g_usb_iface);
-    printf("USB device opened successfully\n");
+    p->speed = libusb_get_device_speed(dev);
+    usb_plan_transfers(p);
+    usb_map_buffers(p);
     return 0;
 
 fail:
     if (cfg) {
         libusb_free_config_descriptor(cfg);
     }
-    if (dev_handle) {
-        libusb_close(dev_handle);
-        dev_handle = NULL;
-    }
-    g_ep_out = 0;
-    g_usb_iface = -1;
-    libusb_exit(NULL);
+    libusb_close(p->handle);
+    p->handle = NULL;
+    p->ep_out = 0;
+    p->iface = -1;
     return -1;
 }
 
-void usb_cleanup(void) {
-    if (dev_handle) {
-        if (g_usb_iface >= 0) {
-            libusb_release_interface(dev_handle, g_usb_iface);
+static void usb_close_device(UsbPanel *p) {
+    if (p->handle) {
+        if (p->iface >= 0) {
+            libusb_release_interface(p->handle, p->iface);
         }
-        libusb_close(dev_handle);
-        dev_handle = NULL;
+        usb_unmap_buffers(p);
+        libusb_close(p->handle);
+        p->handle = NULL;
     }
-    g_ep_out = 0;
-    g_usb_iface = -1;
-    libusb_exit(NULL);
+    p->ep_out = 0;
+    p->iface = -1;
 }
 
-static void build_header(uint8_t hdr[PACKET_SIZE]) {
-    memset(hdr, 0, PACKET_SIZE);
-    hdr[0] = 0xDA; hdr[1] = 0xDB; hdr[2] = 0xDC; hdr[3] = 0xDD; /* magic */
-    hdr[4] = 0x02; hdr[5] = 0x00;   /* ver=2 */
-    hdr[6] = 0x01; hdr[7] = 0x00;   /* cmd=1 */
-    hdr[8] = 0xF0; hdr[9] = 0x00;   /* H=240 */
-    hdr[10] = 0x40; hdr[11] = 0x01; /* W=320 */
-    hdr[12] = 0x02; hdr[13] = 0x00; /* fmt=2 (RGB565) */
-    hdr[22] = 0x00; hdr[23] = 0x58; hdr[24] = 0x02; hdr[25] = 0x00; /* frame_len = 0x00025800 */
-    hdr[26] = 0x00; hdr[27] = 0x00; hdr[28] = 0x00; hdr[29] = 0x08; /* extra */
+/* Runs on the event thread; the main loop does the actual re-open. */
+static int usb_hotplug_cb(libusb_context *ctx, libusb_device *dev,
+                          libusb_hotplug_event event, void *user_data) {
+    (void)ctx; (void)dev; (void)event;
+    UsbPanel *p = user_data;
+    atomic_store(&p->arrived, 1);
+    return 0;
 }
 
-int send_frame(void) {
-    uint8_t packet[PACKET_SIZE];
-    int transferred;
-    int rc;
+static void usb_schedule_retry(UsbPanel *p) {
+    p->retry_ms = USB_RETRY_MIN_MS;
+    clock_gettime(CLOCK_MONOTONIC, &p->last_attempt);
+}
 
-    /* Send header packet first */
-    build_header(packet);
-    rc = libusb_bulk_transfer(dev_handle, g_ep_out, packet, PACKET_SIZE, &transferred, 1000);
-    if (rc < 0 || transferred != PACKET_SIZE) {
-        if (rc < 0) {
-            fprintf(stderr, "USB header transfer failed: %s\n", libusb_error_name(rc));
+/*
+ * Drop the handle after a failed transfer. In-flight slots are allowed to
+ * complete (with NO_DEVICE when unplugged) before the handle is closed.
+ */
+static void usb_device_lost(UsbPanel *p) {
+    wait_transport_idle(p);
+    usb_close_device(p);
+    pthread_mutex_lock(&g_usb_lock);
+    p->failed = 0;
+    p->halted = 0;
+    pthread_mutex_unlock(&g_usb_lock);
+
+    fprintf(stderr, "USB device lost, waiting for it to come back\n");
+    usb_schedule_retry(p);
+    framebuffer = panel_back_buffer(p);
+}
+
+/*
+ * Try to re-open the panel: immediately after a hotplug arrival, otherwise
+ * on an exponential backoff. Hotplug notifications can race udev, so the
+ * backoff keeps running even when hotplug is available.
+ */
+static int usb_reconnect(UsbPanel *p) {
+    if (!atomic_exchange(&p->arrived, 0) &&
+        elapsed_ms(&p->last_attempt) < p->retry_ms) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &p->last_attempt);
+    if (usb_open_device(p, 0) < 0) {
+        p->retry_ms = p->retry_ms * 2 < USB_RETRY_MAX_MS ? p->retry_ms * 2 : USB_RETRY_MAX_MS;
+        return -1;
+    }
+
+    printf("USB device %04X:%04X reconnected (%s speed)\n",
+           p->cfg.vid, p->cfg.pid, usb_speed_name(p->speed));
+    p->have_last_hash = 0;
+    framebuffer = panel_back_buffer(p);
+    return 0;
+}
+
+/*
+ * Open every configured panel (--device, or --vid/--pid as a single panel).
+ * Panels missing at startup are picked up later by the reconnect path;
+ * only a start with no panel at all fails.
+ */
+int usb_init(void) {
+    int rc = libusb_init(NULL);
+    if (rc < 0) {
+        fprintf(stderr, "Failed to init libusb\n");
+        return -1;
+    }
+
+    g_panel_count = g_num_panels > 0 ? g_num_panels : 1;
+    int opened = 0;
+    for (int i = 0; i < g_panel_count; i++) {
+        UsbPanel *p = &g_panels[i];
+        if (g_num_panels > 0) {
+            p->cfg = g_panel_cfg[i];
         } else {
-            fprintf(stderr, "USB header transfer short write: %d/%d\n", transferred, PACKET_SIZE);
+            p->cfg = (PanelConfig){g_vid, g_pid, -1, -1};
         }
+        p->handle = NULL;
+        p->iface = -1;
+        p->hotplug_registered = 0;
+        atomic_store(&p->arrived, 0);
+        if (usb_alloc_buffers(p) < 0) {
+            opened = 0;
+            break;
+        }
+        if (usb_open_device(p, 1) == 0) {
+            printf("Found OUT endpoint: 0x%02X on interface %d (bus %d address %d)\n",
+                   p->ep_out, p->iface, p->bus, p->addr);
+            printf("USB link: %s speed, wMaxPacketSize %d, %d-byte submissions, %u ms timeout, %s buffers\n",
+                   usb_speed_name(p->speed), p->max_packet, atomic_load(&p->chunk), p->timeout_ms,
+                   p->slots[USB_SLOTS - 1].dma ? "usbfs-mapped" : "heap");
+            opened++;
+        } else {
+            usb_schedule_retry(p);
+        }
+    }
+    if (opened == 0 || usb_transport_start() < 0) {
+        for (int i = 0; i < g_panel_count; i++) {
+            usb_close_device(&g_panels[i]);
+            usb_free_buffers(&g_panels[i]);
+        }
+        g_panel_count = 0;
+        libusb_exit(NULL);
         return -1;
     }
 
-    /* Convert framebuffer (portrait 240x320) and send */
-    static uint8_t frame_data[FRAME_SIZE];
+    int hotplug = libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG);
+    for (int i = 0; i < g_panel_count && hotplug; i++) {
+        UsbPanel *p = &g_panels[i];
+        rc = libusb_hotplug_register_callback(NULL, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED,
+                                              LIBUSB_HOTPLUG_NO_FLAGS, p->cfg.vid, p->cfg.pid,
+                                              LIBUSB_HOTPLUG_MATCH_ANY, usb_hotplug_cb,
+                                              p, &p->hotplug);
+        p->hotplug_registered = (rc == LIBUSB_SUCCESS);
+        hotplug = p->hotplug_registered;
+    }
+    if (!hotplug) {
+        printf("USB hotplug unavailable, polling for reconnects\n");
+    }
+
+    usb_select_panel(0);
+    printf("USB device opened successfully (%d/%d panels)\n", opened, g_panel_count);
+    return 0;
+}
+
+/* Upper bound of the bucket the pct-th percentile frame falls in, capped at the max. */
+static uint64_t stats_percentile_us(const UsbStats *st, int pct) {
+    uint64_t rank = (st->completed * (uint64_t)pct + 99) / 100;
+    uint64_t seen = 0;
+    int b = 0;
+    for (; b < USB_LAT_BUCKETS - 1; b++) {
+        seen += st->hist[b];
+        if (seen >= rank) break;
+    }
+    uint64_t bound = b < USB_LAT_BUCKETS - 1 ? 2ULL << b : UINT64_MAX;
+    return bound < st->max_us ? bound : st->max_us;
+}
+
+static void usb_print_stats(int panel, int histogram) {
+    UsbStats st;
+    pthread_mutex_lock(&g_usb_lock);
+    st = g_panels[panel].stats;
+    pthread_mutex_unlock(&g_usb_lock);
+
+    printf("USB panel %d: %" PRIu64 " frames (%" PRIu64 " failed), %" PRIu64 " bytes, %" PRIu64
+           " retries, %" PRIu64 " short writes, transfer p50 %.1f ms p99 %.1f ms max %.1f ms\n",
+           panel + 1, st.completed, st.failed, st.bytes, st.retries, st.short_writes,
+           stats_percentile_us(&st, 50) / 1000.0, stats_percentile_us(&st, 99) / 1000.0,
+           st.max_us / 1000.0);
+    for (int b = 0; histogram && b < USB_LAT_BUCKETS; b++) {
+        if (st.hist[b] == 0) continue;
+        printf("  %s %8.3f ms: %" PRIu64 "\n", b < USB_LAT_BUCKETS - 1 ? " <" : ">=",
+               (b < USB_LAT_BUCKETS - 1 ? 2ULL << b : 1ULL << b) / 1000.0, st.hist[b]);
+    }
+}
+
+/*
+ * Transfer statistics of every panel: with the latency histogram when
+ * requested (SIGUSR1), otherwise a summary line every USB_STATS_PERIOD_S.
+ */
+void usb_report_stats(int requested) {
+    if (!requested && elapsed_ms(&g_stats_printed) < USB_STATS_PERIOD_S * 1000L) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &g_stats_printed);
+    for (int i = 0; i < g_panel_count; i++) {
+        usb_print_stats(i, requested);
+    }
+    fflush(stdout);
+}
 
-    for (int y = 0; y < LCD_H; y++) {
-        for (int x = 0; x < LCD_W; x++) {
-            uint16_t pixel = framebuffer[y * LCD_W + x];
-            int idx = (y * LCD_W + x) * 2;
-            frame_data[idx] = pixel & 0xFF;      /* Low byte first */
-            frame_data[idx + 1] = pixel >> 8;    /* High byte second */
+void usb_cleanup(void) {
+    for (int i = 0; i < g_panel_count; i++) {
+        UsbPanel *p = &g_panels[i];
+        if (g_usb_thread_running) {
+            printf("USB panel %d frames sent: %" PRIu64 ", skipped unchanged: %" PRIu64 "\n",
+                   i + 1, p->frames_sent, p->frames_skipped);
+            usb_print_stats(i, 0);
+        }
+        if (p->hotplug_registered) {
+            libusb_hotplug_deregister_callback(NULL, p->hotplug);
+            p->hotplug_registered = 0;
         }
     }
+    usb_transport_stop();
+    for (int i = 0; i < g_panel_count; i++) {
+        usb_close_device(&g_panels[i]);
+        usb_free_buffers(&g_panels[i]);
+    }
+    g_panel_count = 0;
+    libusb_exit(NULL);
+}
 
-    /* Send pixel data in 512-byte packets */
-    for (int offset = 0; offset < FRAME_SIZE; offset += PACKET_SIZE) {
-        int chunk = FRAME_SIZE - offset;
-        if (chunk > PACKET_SIZE) chunk = PACKET_SIZE;
+int usb_panel_count(void) {
+    return g_panel_count;
+}
 
-        memset(packet, 0, PACKET_SIZE);
-        memcpy(packet, frame_data + offset, chunk);
+/* Make panel the target of rendering (framebuffer) and of send_frame. */
+void usb_select_panel(int panel) {
+    g_panel = &g_panels[panel];
+    framebuffer = panel_back_buffer(g_panel);
+}
 
-        rc = libusb_bulk_transfer(dev_handle, g_ep_out, packet, PACKET_SIZE, &transferred, 1000);
-        if (rc < 0 || transferred != PACKET_SIZE) {
-            if (rc < 0) {
-                fprintf(stderr, "USB data transfer failed: %s\n", libusb_error_name(rc));
-            } else {
-                fprintf(stderr, "USB data transfer short write at offset %d: %d/%d\n",
-                        offset, transferred, PACKET_SIZE);
-            }
-            return -1;
+/*
+ * Queue the selected panel's framebuffer for transmission and return
+ * without waiting for the bus. Two slots alternate so the next frame can be
+ * rendered while the previous one is still being transferred by the event
+ * thread: on return framebuffer points at the other slot, once that slot is
+ * idle. Frames go out one after the other: a frame is submitted only once
+ * the previous one has left the bus, so their chunks never interleave. Frames identical to the last transmitted one are dropped unless
+ * g_keepalive seconds have passed since it went out.
+ *
+ * A failed transfer closes the device instead of ending the session;
+ * until it is re-opened frames are dropped and -1 is returned. A stalled
+ * endpoint only costs the frame that hit it: the halt is cleared here
+ * before the next one goes out.
+ */
+static int queue_frame(int unchanged) {
+    UsbPanel *p = g_panel;
+
+    if (transport_failed(p)) {
+        usb_device_lost(p);
+    }
+    if (p->handle && transport_halted(p)) {
+        wait_transport_idle(p);
+        int rc = libusb_clear_halt(p->handle, p->ep_out);
+        if (rc < 0) {
+            fprintf(stderr, "USB clear halt failed: %s\n", libusb_error_name(rc));
+            usb_device_lost(p);
         }
     }
+    if (!p->handle && usb_reconnect(p) < 0) {
+        p->have_queued_hash = 0;
+        return -1;
+    }
 
+    uint64_t hash = unchanged && p->have_queued_hash ? p->queued_hash
+                                                     : pixel_hash64(framebuffer, FRAME_SIZE);
+    p->have_queued_hash = 1;
+    p->queued_hash = hash;
+    if (p->have_last_hash && hash == p->last_hash &&
+        elapsed_ms(&p->last_sent) < g_keepalive * 1000L) {
+        p->frames_skipped++;
+        return 0;
+    }
+
+    /*
+     * The previous frame may still be resubmitting chunks from the event
+     * thread; this one's header must not go out between them.
+     */
+    wait_slot_idle(&p->slots[(p->next_slot + USB_SLOTS - 1) % USB_SLOTS]);
+
+    FrameSlot *slot = &p->slots[p->next_slot];
+    slot->offset = 0;
+    slot->bytes = 0;
+    slot->retries = 0;
+    slot->short_write = 0;
+    clock_gettime(CLOCK_MONOTONIC, &slot->submitted);
+    pthread_mutex_lock(&g_usb_lock);
+    slot->busy = 1;
+    pthread_mutex_unlock(&g_usb_lock);
+
+    int rc = submit_chunk(slot);
+    if (submit_rejected(rc)) {
+        rc = retry_in_packets(slot, libusb_error_name(rc));
+    }
+    if (rc < 0) {
+        finish_slot(slot, FRAME_FAILED);
+        usb_device_lost(p);
+        return -1;
+    }
+
+    p->have_last_hash = 1;
+    p->last_hash = hash;
+    clock_gettime(CLOCK_MONOTONIC, &p->last_sent);
+    p->frames_sent++;
+
+    /* Flip to the other slot; it must be off the bus before we draw into it. */
+    p->next_slot = (p->next_slot + 1) % USB_SLOTS;
+    slot = &p->slots[p->next_slot];
+    wait_slot_idle(slot);
+    framebuffer = panel_back_buffer(p);
     return 0;
 }
+
+int send_frame(void) {
+    return queue_frame(0);
+}
+
+/*
+ * send_frame() for a frame the caller knows to be pixel for pixel the one
+ * it last passed for this panel, e.g. a render that repainted nothing: the
+ * hash of that frame is reused instead of hashing the buffer again.
+ */
+int send_unchanged_frame(void) {
+    return queue_frame(1);
+}
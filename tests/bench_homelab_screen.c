@@ -0,0 +1,409 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ * Copyright (C) 2026 homelab-screen contributors
+ */
+
+/*
+ * Render and transfer microbenchmarks, built against the libusb test
+ * doubles by `make bench`. Every benchmark is timed as a series of samples,
+ * each a batch of calls sized to take about SAMPLE_NS; min, median and p99
+ * are over the per-call time of the samples. `--json PATH` also writes the
+ * results as JSON for tracking between releases.
+ */
+
+#define _GNU_SOURCE
+#define TESTING 1
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define main homelab_screen_main
+#include "../homelab-screen.c"
+#undef main
+
+#define SAMPLES 200
+#define SAMPLE_NS 200000.0
+
+static uint16_t g_bench_fb[LCD_W * LCD_H];
+static uint8_t g_bench_idx[LCD_W * LCD_H];
+static Surface g_bench;
+static Surface g_bench_indexed;
+
+/* Baseline: the per-pixel sqrtf/atan2f gauge before the ring tables. */
+static void draw_circle_progress_trig(Surface *s, int cx, int cy, int radius, int thickness, float pct,
+                                      uint16_t bg_color, uint16_t fg_color) {
+    float angle_max = (pct / 100.0f) * 2.0f * M_PI;
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            float dist = sqrtf(x*x + y*y);
+            if (dist >= radius - thickness && dist <= radius) {
+                float angle = atan2f(-x, -y) + M_PI;
+                set_pixel(s, cx + x, cy + y, (angle <= angle_max) ? fg_color : bg_color);
+            }
+        }
+    }
+}
+
+/* Baseline: rounded rectangle corners drawn pixel by pixel. */
+static void draw_rounded_rect_pixels(Surface *s, int x, int y, int w, int h, int r, uint16_t color) {
+    fill_rect(s, x + r, y, w - 2*r, h, color);
+    fill_rect(s, x, y + r, r, h - 2*r, color);
+    fill_rect(s, x + w - r, y + r, r, h - 2*r, color);
+    for (int cy = 0; cy < r; cy++) {
+        for (int cx = 0; cx < r; cx++) {
+            int dx = r - 1 - cx;
+            int dy = r - 1 - cy;
+            if (dx*dx + dy*dy <= r*r) {
+                set_pixel(s, x + cx, y + cy, color);
+                set_pixel(s, x + w - 1 - cx, y + cy, color);
+                set_pixel(s, x + cx, y + h - 1 - cy, color);
+                set_pixel(s, x + w - 1 - cx, y + h - 1 - cy, color);
+            }
+        }
+    }
+}
+
+/* Baseline: the bit-by-bit glyph loop before the span cache. */
+static void draw_char_bitwise(Surface *s, int x, int y, char c, uint16_t color, int scale) {
+    if (c < 0x20 || c > 0x7E) c = '?';
+    int idx = c - 0x20;
+    for (int row = 0; row < 16; row++) {
+        uint8_t bits = font8x16[idx][row];
+        for (int col = 0; col < 8; col++) {
+            if (bits & (0x80 >> col)) {
+                for (int sy = 0; sy < scale; sy++) {
+                    for (int sx = 0; sx < scale; sx++) {
+                        set_pixel(s, x + col*scale + sx, y + row*scale + sy, color);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* A /proc/stat and /proc/meminfo as read on a small 4-core host. */
+static const char g_proc_stat[] =
+    "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n"
+    "cpu0 1393 280 219 924480 7530 0 186 0 0 0\n"
+    "cpu1 1125 11 101 925139 5209 0 47 0 0 0\n"
+    "cpu2 1107 38 145 924663 5106 0 25 0 0 0\n"
+    "cpu3 1080 27 119 924894 5215 0 19 0 0 0\n"
+    "intr 1462898 33 0 0 0 0 0 0 0 1 0 0 0 0\n"
+    "ctxt 2549713\nbtime 1700000000\nprocesses 10297\n";
+static const char g_proc_meminfo[] =
+    "MemTotal:       16318852 kB\nMemFree:         1234567 kB\nMemAvailable:    8000000 kB\n"
+    "Buffers:          400000 kB\nCached:          5000000 kB\nSwapCached:            0 kB\n"
+    "Active:          6000000 kB\nInactive:        4000000 kB\nActive(anon):    3000000 kB\n"
+    "Inactive(anon):   100000 kB\nActive(file):    3000000 kB\nInactive(file):  3900000 kB\n"
+    "Unevictable:           0 kB\nMlocked:               0 kB\nSwapTotal:       2097148 kB\n"
+    "SwapFree:        2097148 kB\nDirty:               100 kB\nWriteback:             0 kB\n"
+    "AnonPages:       3000000 kB\nMapped:           500000 kB\nShmem:            100000 kB\n";
+
+/* Baseline: the sscanf parse of the aggregate cpu line. */
+static int parse_stat_sscanf(const char *buf, uint64_t f[7]) {
+    return sscanf(buf, "cpu %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                  " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                  &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6]) == 7 ? 0 : -1;
+}
+
+/* Baseline: every meminfo line through strncmp and sscanf. */
+static void parse_meminfo_sscanf(const char *line, uint64_t *total, uint64_t *avail) {
+    while (line) {
+        if (strncmp(line, "MemTotal:", 9) == 0)
+            sscanf(line + 9, " %" SCNu64, total);
+        else if (strncmp(line, "MemAvailable:", 13) == 0)
+            sscanf(line + 13, " %" SCNu64, avail);
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ========== Operations, each called with a running iteration count ========== */
+
+static const char g_text[] = "12.5 GB/s";
+static int g_scale = 1;
+static void (*g_page)(Surface *s);
+
+static void op_fill_screen(int i) {
+    fill_rect(&g_bench, 0, 0, LCD_W, LCD_H, (uint16_t)i);
+}
+
+static void op_fill_screen_indexed(int i) {
+    fill_rect(&g_bench_indexed, 0, 0, LCD_W, LCD_H, (i & 1) ? COLOR_BG_CARD : COLOR_BG);
+}
+
+static void op_fill_small(int i) {
+    fill_rect(&g_bench, 40 + i % 64, 100, 40, 16, COLOR_BG_CARD);
+}
+
+static void op_rounded_rect(int i) {
+    (void)i;
+    draw_rounded_rect(&g_bench, 10, 90, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+}
+
+static void op_rounded_rect_pixels(int i) {
+    (void)i;
+    draw_rounded_rect_pixels(&g_bench, 10, 90, LCD_W - 20, 90, 8, COLOR_BG_CARD);
+}
+
+static void op_draw_string(int i) {
+    draw_string(&g_bench, i % 16, 40, g_text, COLOR_WHITE, g_scale);
+}
+
+static void op_draw_string_bitwise(int i) {
+    for (int c = 0; g_text[c]; c++) {
+        draw_char_bitwise(&g_bench, i % 16 + c * 8 * g_scale, 40, g_text[c], COLOR_WHITE, g_scale);
+    }
+}
+
+static void op_gauge(int i) {
+    draw_circle_progress(&g_bench, LCD_W / 2, 155, 85, 14, (float)(i % 101), COLOR_BG_GAUGE, COLOR_CYAN);
+}
+
+static void op_gauge_trig(int i) {
+    draw_circle_progress_trig(&g_bench, LCD_W / 2, 155, 85, 14, (float)(i % 101), COLOR_BG_GAUGE, COLOR_CYAN);
+}
+
+static void op_progress_bar(int i) {
+    draw_progress_bar(&g_bench, 20, 200, LCD_W - 40, 16, (float)(i % 101), COLOR_BG_CARD, COLOR_GREEN);
+}
+
+/* One tick of moving values, as the collectors produce them. */
+static void tick_metrics(int i) {
+    g_metrics.cpu_usage = (float)(i % 101);
+    g_metrics.cpu_temp = 40.0f + (float)(i % 40);
+    g_metrics.mem_pct = (float)(i * 7 % 101);
+    g_metrics.mem_used = (uint64_t)(i % 16 + 1) * 1024 * 1024 * 1024;
+    g_metrics.net_rx_rate = (float)(i % 1000) * 1024.0f * 1024.0f;
+    g_metrics.net_tx_rate = (float)(i % 300) * 1024.0f;
+    g_metrics.load_1 = (float)(i % 50) / 10.0f;
+    g_metrics.core_pct[i % 64] = (uint8_t)(i * 37 % 101);
+    g_pve_metrics.running_vms = i % 12;
+    g_pve_metrics.storage[0].used_pct = (float)(i % 101);
+}
+
+static void op_page(int i) {
+    tick_metrics(i);
+    g_page(&g_bench);
+}
+
+static void op_page_full(int i) {
+    render_release(g_bench_fb, FRAME_SIZE);
+    tick_metrics(i);
+    g_page(&g_bench);
+}
+
+static void op_expand(int i) {
+    (void)i;
+    surface_expand(g_bench_fb, &g_bench_indexed);
+}
+
+static void op_hash(int i) {
+    (void)i;
+    volatile uint64_t h = pixel_hash64(g_bench_fb, FRAME_SIZE);
+    (void)h;
+}
+
+static void op_parse_stat(int i) {
+    (void)i;
+    uint64_t f[7];
+    const char *p = g_proc_stat + 4;
+    volatile int n = scan_cpu_fields(&p, f, 7);
+    (void)n;
+}
+
+static void op_parse_stat_sscanf(int i) {
+    (void)i;
+    uint64_t f[7];
+    volatile int rc = parse_stat_sscanf(g_proc_stat, f);
+    (void)rc;
+}
+
+static void op_parse_meminfo(int i) {
+    (void)i;
+    uint64_t kb[MEM_KEYS];
+    volatile unsigned found = parse_meminfo(g_proc_meminfo, kb);
+    (void)found;
+}
+
+static void op_parse_meminfo_sscanf(int i) {
+    (void)i;
+    uint64_t total = 0, avail = 0;
+    parse_meminfo_sscanf(g_proc_meminfo, &total, &avail);
+    volatile uint64_t used = total - avail;
+    (void)used;
+}
+
+/* A changed frame per call, so the unchanged-frame skip never applies. */
+static void op_send_frame(int i) {
+    framebuffer[i % (LCD_W * LCD_H)] ^= 0x0101;
+    send_frame();
+}
+
+/* ========== Harness ========== */
+
+typedef struct {
+    char name[48];
+    long calls;
+    double min, median, p99; /* ns per call */
+} BenchResult;
+
+static BenchResult g_results[64];
+static int g_result_count = 0;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench(const char *name, void (*op)(int)) {
+    static int counter = 0;
+    double samples[SAMPLES];
+
+    /* Warm up the caches and tables, then size the batch from one timed call. */
+    for (int i = 0; i < 3; i++) op(counter++);
+    double start = now_ns();
+    op(counter++);
+    double one = now_ns() - start;
+    int batch = one >= SAMPLE_NS ? 1 : (int)(SAMPLE_NS / (one > 1.0 ? one : 1.0));
+
+    for (int s = 0; s < SAMPLES; s++) {
+        start = now_ns();
+        for (int i = 0; i < batch; i++) op(counter++);
+        samples[s] = (now_ns() - start) / batch;
+    }
+    qsort(samples, SAMPLES, sizeof(samples[0]), cmp_double);
+
+    BenchResult *r = &g_results[g_result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->calls = (long)batch * SAMPLES;
+    r->min = samples[0];
+    r->median = samples[SAMPLES / 2];
+    r->p99 = samples[(SAMPLES - 1) * 99 / 100];
+}
+
+static int write_json(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(f, "{\n  \"kernels\": \"%s\",\n  \"unit\": \"ns/call\",\n  \"samples\": %d,\n  \"results\": [\n",
+            pixel_kernels_name(), SAMPLES);
+    for (int i = 0; i < g_result_count; i++) {
+        const BenchResult *r = &g_results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"calls\": %ld, \"min\": %.1f, \"median\": %.1f, \"p99\": %.1f}%s\n",
+                r->name, r->calls, r->min, r->median, r->p99, i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    const char *json = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--json PATH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    g_bench = surface_wrap(g_bench_fb, LCD_W, LCD_H, LCD_W);
+    g_bench_indexed = surface_wrap_indexed(g_bench_idx, LCD_W, LCD_H, LCD_W);
+    snprintf(g_metrics.hostname, sizeof(g_metrics.hostname), "bench-host");
+    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+    g_metrics.mem_total = 16ULL * 1024 * 1024 * 1024;
+    g_metrics.core_count = 64;
+    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "pve");
+    g_pve_metrics.total_vms = 12;
+    g_pve_metrics.storage_count = 2;
+    for (int i = 0; i < 2; i++) {
+        snprintf(g_pve_metrics.storage[i].name, sizeof(g_pve_metrics.storage[i].name), "tank%d", i);
+        g_pve_metrics.storage[i].total_bytes = 100ULL * 1024 * 1024 * 1024;
+    }
+
+    bench("fill_rect 240x320", op_fill_screen);
+    bench("fill_rect 240x320 indexed", op_fill_screen_indexed);
+    bench("fill_rect 40x16", op_fill_small);
+    bench("draw_rounded_rect r=8", op_rounded_rect);
+    bench("baseline/draw_rounded_rect r=8", op_rounded_rect_pixels);
+    for (g_scale = 1; g_scale <= GLYPH_MAX_SCALE; g_scale++) {
+        char name[48];
+        snprintf(name, sizeof(name), "draw_string scale %d", g_scale);
+        bench(name, op_draw_string);
+        snprintf(name, sizeof(name), "baseline/draw_string scale %d", g_scale);
+        bench(name, op_draw_string_bitwise);
+    }
+    bench("draw_circle_progress", op_gauge);
+    bench("baseline/draw_circle_progress", op_gauge_trig);
+    bench("draw_progress_bar", op_progress_bar);
+
+    struct {
+        void (*render)(Surface *s);
+        const char *name;
+    } pages[] = {
+        {render_page_overview, "overview"}, {render_page_cpu, "cpu"}, {render_page_cores, "cores"},
+        {render_page_memory, "memory"},
+        {render_page_network, "network"}, {render_page_system, "system"},
+        {render_page_proxmox, "proxmox"}, {render_page_storage, "storage"},
+    };
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); p++) {
+        char name[48];
+        g_page = pages[p].render;
+        render_release(g_bench_fb, FRAME_SIZE);
+        snprintf(name, sizeof(name), "render_page_%s", pages[p].name);
+        bench(name, op_page);
+        snprintf(name, sizeof(name), "render_page_%s full", pages[p].name);
+        bench(name, op_page_full);
+    }
+
+    g_page = render_page_overview;
+    op_page(0);
+    render_page_overview(&g_bench_indexed);
+    bench("surface_expand (palette)", op_expand);
+    bench("pixel_hash64 frame", op_hash);
+    bench("parse /proc/stat cpu", op_parse_stat);
+    bench("baseline/parse /proc/stat cpu", op_parse_stat_sscanf);
+    bench("parse /proc/meminfo", op_parse_meminfo);
+    bench("baseline/parse /proc/meminfo", op_parse_meminfo_sscanf);
+
+    /* send_frame through the mock transport: hash, submit and slot flip. */
+    int quiet = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    mock_libusb_reset();
+    int usb_ok = usb_init() == 0;
+    if (usb_ok) {
+        bench("send_frame", op_send_frame);
+        usb_cleanup();
+    }
+    fflush(stdout);
+    dup2(quiet, STDOUT_FILENO);
+    close(devnull);
+    close(quiet);
+
+    printf("Pixel kernels: %s, %d samples per benchmark\n", pixel_kernels_name(), SAMPLES);
+    printf("%-36s %12s %12s %12s %10s\n", "benchmark (ns/call)", "min", "median", "p99", "calls");
+    for (int i = 0; i < g_result_count; i++) {
+        const BenchResult *r = &g_results[i];
+        printf("%-36s %12.1f %12.1f %12.1f %10ld\n", r->name, r->min, r->median, r->p99, r->calls);
+    }
+    if (!usb_ok) {
+        fprintf(stderr, "send_frame skipped: mock USB init failed\n");
+    }
+    if (json && write_json(json) != 0) {
+        return 1;
+    }
+    return 0;
+}
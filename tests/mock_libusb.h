@@ -11,16 +11,44 @@
 #ifndef MOCK_LIBUSB_H
 #define MOCK_LIBUSB_H
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
-
-typedef struct libusb_device { int dummy; } libusb_device;
-typedef struct libusb_device_handle { int dummy; } libusb_device_handle;
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef struct libusb_context { int dummy; } libusb_context;
+typedef struct libusb_device {
+    uint16_t vid;
+    uint16_t pid;
+    int bus;
+    int addr;
+    int present;
+} libusb_device;
+typedef struct libusb_device_handle { libusb_device *dev; } libusb_device_handle;
+
+/* Device descriptor (only the fields the daemon reads) */
+struct libusb_device_descriptor {
+    uint16_t idVendor;
+    uint16_t idProduct;
+};
 
 /* Endpoint descriptor */
 struct libusb_endpoint_descriptor {
     uint8_t bEndpointAddress;
+    uint16_t wMaxPacketSize;
+};
+
+enum libusb_speed {
+    LIBUSB_SPEED_UNKNOWN = 0,
+    LIBUSB_SPEED_LOW = 1,
+    LIBUSB_SPEED_FULL = 2,
+    LIBUSB_SPEED_HIGH = 3,
+    LIBUSB_SPEED_SUPER = 4,
+    LIBUSB_SPEED_SUPER_PLUS = 5
 };
 
 /* Interface descriptor */
@@ -42,45 +70,192 @@ struct libusb_config_descriptor {
     const struct libusb_interface *interface;
 };
 
+/* Error codes */
+enum libusb_error {
+    LIBUSB_SUCCESS = 0,
+    LIBUSB_ERROR_IO = -1,
+    LIBUSB_ERROR_INVALID_PARAM = -2,
+    LIBUSB_ERROR_ACCESS = -3,
+    LIBUSB_ERROR_NO_DEVICE = -4,
+    LIBUSB_ERROR_NOT_FOUND = -5,
+    LIBUSB_ERROR_BUSY = -6,
+    LIBUSB_ERROR_TIMEOUT = -7,
+    LIBUSB_ERROR_OVERFLOW = -8,
+    LIBUSB_ERROR_PIPE = -9,
+    LIBUSB_ERROR_INTERRUPTED = -10,
+    LIBUSB_ERROR_NO_MEM = -11,
+    LIBUSB_ERROR_NOT_SUPPORTED = -12,
+    LIBUSB_ERROR_OTHER = -99
+};
+
+/* Async transfer API */
+enum libusb_transfer_status {
+    LIBUSB_TRANSFER_COMPLETED,
+    LIBUSB_TRANSFER_ERROR,
+    LIBUSB_TRANSFER_TIMED_OUT,
+    LIBUSB_TRANSFER_CANCELLED,
+    LIBUSB_TRANSFER_STALL,
+    LIBUSB_TRANSFER_NO_DEVICE,
+    LIBUSB_TRANSFER_OVERFLOW
+};
+
+#define LIBUSB_TRANSFER_TYPE_BULK 2
+
+struct libusb_transfer;
+typedef void (*libusb_transfer_cb_fn)(struct libusb_transfer *transfer);
+
+struct libusb_transfer {
+    libusb_device_handle *dev_handle;
+    uint8_t flags;
+    unsigned char endpoint;
+    unsigned char type;
+    unsigned int timeout;
+    enum libusb_transfer_status status;
+    int length;
+    int actual_length;
+    libusb_transfer_cb_fn callback;
+    void *user_data;
+    unsigned char *buffer;
+    int num_iso_packets;
+};
+
+/* Hotplug API */
+#define LIBUSB_CAP_HAS_HOTPLUG 0x0001
+#define LIBUSB_HOTPLUG_NO_FLAGS 0
+#define LIBUSB_HOTPLUG_MATCH_ANY -1
+
+typedef enum {
+    LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED = 0x01,
+    LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT = 0x02
+} libusb_hotplug_event;
+
+typedef int libusb_hotplug_callback_handle;
+typedef int (*libusb_hotplug_callback_fn)(libusb_context *ctx, libusb_device *device,
+                                          libusb_hotplug_event event, void *user_data);
+
 /* Tunable mock state */
 static int mock_libusb_init_rc = 0;
+static int mock_libusb_device_list_rc = 0;
+static int mock_libusb_descriptor_rc = 0;
 static int mock_libusb_open_ok = 1;
 static int mock_libusb_set_auto_detach_rc = 0;
 static int mock_libusb_claim_interface_rc = 0;
 static int mock_libusb_release_interface_rc = 0;
 static int mock_libusb_get_active_config_rc = 0;
 static int mock_libusb_force_cfg_on_error = 0;
-static int mock_libusb_bulk_transfer_rc = 0;
-static int mock_libusb_bulk_short_write = 0;
-static int mock_libusb_bulk_short_write_after = -1;
-static int mock_libusb_bulk_fail_after = -1; /* fail after N successful calls, -1 means never */
+static int mock_libusb_alloc_transfer_fail = 0;
+static int mock_libusb_submit_rc = 0;
+static int mock_libusb_submit_fail_after = -1; /* fail after N successful submits, -1 means never */
+static int mock_libusb_transfer_status = LIBUSB_TRANSFER_ERROR;
+static int mock_libusb_transfer_fail_after = -1; /* complete with mock_libusb_transfer_status after N */
+static int mock_libusb_short_write = 0;
+static int mock_libusb_short_write_after = -1;
+static int mock_libusb_reject_len_above = 0; /* submit fails for longer transfers, 0 means never */
+static int mock_libusb_stall_len_above = 0;  /* longer transfers complete with STALL, 0 means never */
+static int mock_libusb_fail_len_above = 0;   /* same, with mock_libusb_transfer_status */
+static int mock_libusb_halted = 0;           /* set by a STALL, submits stall until cleared */
+static int mock_libusb_clear_halt_rc = 0;
+static int mock_libusb_clear_halt_calls = 0;
+
+static int mock_libusb_hotplug_supported = 1;
+static int mock_libusb_dev_mem_ok = 1;      /* 0: kernel without usbfs mmap */
+static int mock_libusb_hotplug_register_rc = 0;
+
+/* Attached devices; transfers to a device that is not present fail. */
+#define MOCK_LIBUSB_MAX_DEVICES 4
+static libusb_device mock_libusb_devices[MOCK_LIBUSB_MAX_DEVICES];
+static libusb_device_handle mock_libusb_handles[MOCK_LIBUSB_MAX_DEVICES];
+static int mock_libusb_device_count = 0;
 
 static int mock_libusb_claimed_iface = -1;
 static int mock_libusb_released_iface = -1;
-static int mock_libusb_bulk_calls = 0;
+static int mock_libusb_submit_calls = 0;
+static int mock_libusb_dev_mem_mapped = 0;  /* outstanding libusb_dev_mem_alloc buffers */
+
+/* Submitted payload bytes are captured for content checks. */
+#define MOCK_LIBUSB_CAPTURE_SIZE (1024 * 1024)
+static unsigned char mock_libusb_capture[MOCK_LIBUSB_CAPTURE_SIZE];
+static size_t mock_libusb_captured = 0;
+
+/* Submitted transfers wait here until the event handler completes them. */
+#define MOCK_LIBUSB_MAX_PENDING 16
+typedef struct {
+    struct libusb_transfer *transfer;
+    enum libusb_transfer_status status;
+    int actual_length;
+} MockPendingTransfer;
+
+static pthread_mutex_t mock_libusb_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mock_libusb_cond = PTHREAD_COND_INITIALIZER;
+static MockPendingTransfer mock_libusb_pending[MOCK_LIBUSB_MAX_PENDING];
+static int mock_libusb_pending_count = 0;
+static int mock_libusb_interrupted = 0;
+#define MOCK_LIBUSB_MAX_HOTPLUG 4
+static libusb_hotplug_callback_fn mock_libusb_hotplug_cb[MOCK_LIBUSB_MAX_HOTPLUG];
+static void *mock_libusb_hotplug_user_data[MOCK_LIBUSB_MAX_HOTPLUG];
+static int mock_libusb_hotplug_count = 0;
+static int mock_libusb_arrival_pending = 0;
 
 static int mock_libusb_has_out_endpoint = 1;
 static int mock_libusb_interface_number = 0;
 static unsigned char mock_libusb_endpoint_addr = 0x02;
+static uint16_t mock_libusb_max_packet = 512;
+static int mock_libusb_speed = LIBUSB_SPEED_HIGH;
+
+static inline void mock_libusb_add_device(uint16_t vid, uint16_t pid, int bus, int addr) {
+    libusb_device *dev = &mock_libusb_devices[mock_libusb_device_count++];
+    dev->vid = vid;
+    dev->pid = pid;
+    dev->bus = bus;
+    dev->addr = addr;
+    dev->present = 1;
+}
 
 static inline void mock_libusb_reset(void) {
     mock_libusb_init_rc = 0;
+    mock_libusb_device_list_rc = 0;
+    mock_libusb_descriptor_rc = 0;
     mock_libusb_open_ok = 1;
+    mock_libusb_device_count = 0;
+    mock_libusb_add_device(0x0416, 0x5302, 1, 2);
     mock_libusb_set_auto_detach_rc = 0;
     mock_libusb_claim_interface_rc = 0;
     mock_libusb_release_interface_rc = 0;
     mock_libusb_get_active_config_rc = 0;
     mock_libusb_force_cfg_on_error = 0;
-    mock_libusb_bulk_transfer_rc = 0;
-    mock_libusb_bulk_short_write = 0;
-    mock_libusb_bulk_short_write_after = -1;
-    mock_libusb_bulk_fail_after = -1;
+    mock_libusb_alloc_transfer_fail = 0;
+    mock_libusb_submit_rc = 0;
+    mock_libusb_submit_fail_after = -1;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_ERROR;
+    mock_libusb_transfer_fail_after = -1;
+    mock_libusb_short_write = 0;
+    mock_libusb_short_write_after = -1;
+    mock_libusb_reject_len_above = 0;
+    mock_libusb_stall_len_above = 0;
+    mock_libusb_fail_len_above = 0;
+    mock_libusb_halted = 0;
+    mock_libusb_clear_halt_rc = 0;
+    mock_libusb_clear_halt_calls = 0;
+    mock_libusb_hotplug_supported = 1;
+    mock_libusb_dev_mem_ok = 1;
+    mock_libusb_dev_mem_mapped = 0;
+    mock_libusb_hotplug_register_rc = 0;
     mock_libusb_claimed_iface = -1;
     mock_libusb_released_iface = -1;
-    mock_libusb_bulk_calls = 0;
+    mock_libusb_submit_calls = 0;
+    mock_libusb_captured = 0;
+    pthread_mutex_lock(&mock_libusb_lock);
+    mock_libusb_pending_count = 0;
+    mock_libusb_interrupted = 0;
+    memset(mock_libusb_hotplug_cb, 0, sizeof(mock_libusb_hotplug_cb));
+    mock_libusb_hotplug_count = 0;
+    mock_libusb_arrival_pending = 0;
+    pthread_mutex_unlock(&mock_libusb_lock);
     mock_libusb_has_out_endpoint = 1;
     mock_libusb_interface_number = 0;
     mock_libusb_endpoint_addr = 0x02;
+    mock_libusb_max_packet = 512;
+    mock_libusb_speed = LIBUSB_SPEED_HIGH;
 }
 
 static inline int libusb_init(void *ctx) {
@@ -92,11 +267,53 @@ static inline void libusb_exit(void *ctx) {
     (void)ctx;
 }
 
-static inline libusb_device_handle *libusb_open_device_with_vid_pid(
-    void *ctx, uint16_t vid, uint16_t pid) {
-    (void)ctx; (void)vid; (void)pid;
-    static libusb_device_handle handle;
-    return mock_libusb_open_ok ? &handle : NULL;
+static inline ssize_t libusb_get_device_list(void *ctx, libusb_device ***list) {
+    (void)ctx;
+    if (mock_libusb_device_list_rc < 0) {
+        return mock_libusb_device_list_rc;
+    }
+    libusb_device **devs = calloc(MOCK_LIBUSB_MAX_DEVICES + 1, sizeof(*devs));
+    ssize_t n = 0;
+    for (int i = 0; i < mock_libusb_device_count; i++) {
+        if (mock_libusb_devices[i].present) {
+            devs[n++] = &mock_libusb_devices[i];
+        }
+    }
+    *list = devs;
+    return n;
+}
+
+static inline void libusb_free_device_list(libusb_device **list, int unref_devices) {
+    (void)unref_devices;
+    free(list);
+}
+
+static inline int libusb_get_device_descriptor(
+    libusb_device *dev, struct libusb_device_descriptor *desc) {
+    if (mock_libusb_descriptor_rc != 0) {
+        return mock_libusb_descriptor_rc;
+    }
+    desc->idVendor = dev->vid;
+    desc->idProduct = dev->pid;
+    return 0;
+}
+
+static inline uint8_t libusb_get_bus_number(libusb_device *dev) {
+    return (uint8_t)dev->bus;
+}
+
+static inline uint8_t libusb_get_device_address(libusb_device *dev) {
+    return (uint8_t)dev->addr;
+}
+
+static inline int libusb_open(libusb_device *dev, libusb_device_handle **handle) {
+    if (!mock_libusb_open_ok) {
+        return LIBUSB_ERROR_ACCESS;
+    }
+    libusb_device_handle *h = &mock_libusb_handles[dev - mock_libusb_devices];
+    h->dev = dev;
+    *handle = h;
+    return 0;
 }
 
 static inline int libusb_set_auto_detach_kernel_driver(
@@ -119,14 +336,45 @@ static inline int libusb_release_interface(
     return mock_libusb_release_interface_rc;
 }
 
+static inline int libusb_clear_halt(libusb_device_handle *dev, unsigned char endpoint) {
+    (void)dev; (void)endpoint;
+    pthread_mutex_lock(&mock_libusb_lock);
+    mock_libusb_clear_halt_calls++;
+    if (mock_libusb_clear_halt_rc == 0) {
+        mock_libusb_halted = 0;
+    }
+    pthread_mutex_unlock(&mock_libusb_lock);
+    return mock_libusb_clear_halt_rc;
+}
+
 static inline void libusb_close(libusb_device_handle *dev) {
     (void)dev;
 }
 
+static inline unsigned char *libusb_dev_mem_alloc(libusb_device_handle *dev, size_t length) {
+    (void)dev;
+    if (!mock_libusb_dev_mem_ok) {
+        return NULL;
+    }
+    mock_libusb_dev_mem_mapped++;
+    return calloc(1, length);
+}
+
+static inline int libusb_dev_mem_free(libusb_device_handle *dev, unsigned char *buffer, size_t length) {
+    (void)dev;
+    (void)length;
+    mock_libusb_dev_mem_mapped--;
+    free(buffer);
+    return 0;
+}
+
 static inline libusb_device *libusb_get_device(libusb_device_handle *dev) {
+    return dev->dev;
+}
+
+static inline int libusb_get_device_speed(libusb_device *dev) {
     (void)dev;
-    static libusb_device device;
-    return &device;
+    return mock_libusb_speed;
 }
 
 static inline int libusb_get_active_config_descriptor(
@@ -153,6 +401,8 @@ static inline int libusb_get_active_config_descriptor(
         ? mock_libusb_endpoint_addr
         : (unsigned char)(mock_libusb_endpoint_addr | 0x80);
 
+    ep_desc.wMaxPacketSize = mock_libusb_max_packet;
+
     iface_desc.bInterfaceNumber = mock_libusb_interface_number;
     iface_desc.bNumEndpoints = 1;
     iface_desc.endpoint = &ep_desc;
@@ -172,29 +422,189 @@ static inline void libusb_free_config_descriptor(
     (void)cfg;
 }
 
-static inline int libusb_bulk_transfer(
-    libusb_device_handle *dev, unsigned char endpoint,
-    unsigned char *data, int length, int *transferred, unsigned int timeout) {
-    (void)dev; (void)endpoint; (void)data; (void)length; (void)timeout;
+static inline struct libusb_transfer *libusb_alloc_transfer(int iso_packets) {
+    (void)iso_packets;
+    if (mock_libusb_alloc_transfer_fail) {
+        return NULL;
+    }
+    return calloc(1, sizeof(struct libusb_transfer));
+}
+
+static inline void libusb_free_transfer(struct libusb_transfer *transfer) {
+    free(transfer);
+}
+
+static inline void libusb_fill_bulk_transfer(
+    struct libusb_transfer *transfer, libusb_device_handle *dev,
+    unsigned char endpoint, unsigned char *buffer, int length,
+    libusb_transfer_cb_fn callback, void *user_data, unsigned int timeout) {
+    transfer->dev_handle = dev;
+    transfer->endpoint = endpoint;
+    transfer->type = LIBUSB_TRANSFER_TYPE_BULK;
+    transfer->timeout = timeout;
+    transfer->buffer = buffer;
+    transfer->length = length;
+    transfer->user_data = user_data;
+    transfer->callback = callback;
+}
+
+static inline int libusb_submit_transfer(struct libusb_transfer *transfer) {
+    pthread_mutex_lock(&mock_libusb_lock);
+    mock_libusb_submit_calls++;
 
-    mock_libusb_bulk_calls++;
+    if (mock_libusb_submit_rc != 0 ||
+        (mock_libusb_submit_fail_after >= 0 &&
+         mock_libusb_submit_calls > mock_libusb_submit_fail_after)) {
+        pthread_mutex_unlock(&mock_libusb_lock);
+        return (mock_libusb_submit_rc != 0) ? mock_libusb_submit_rc : -1;
+    }
+    if (!transfer->dev_handle->dev->present) {
+        pthread_mutex_unlock(&mock_libusb_lock);
+        return LIBUSB_ERROR_NO_DEVICE;
+    }
+    if (mock_libusb_reject_len_above > 0 && transfer->length > mock_libusb_reject_len_above) {
+        pthread_mutex_unlock(&mock_libusb_lock);
+        return LIBUSB_ERROR_INVALID_PARAM;
+    }
+
+    size_t room = MOCK_LIBUSB_CAPTURE_SIZE - mock_libusb_captured;
+    size_t n = (size_t)transfer->length < room ? (size_t)transfer->length : room;
+    memcpy(mock_libusb_capture + mock_libusb_captured, transfer->buffer, n);
+    mock_libusb_captured += n;
+
+    int short_write = mock_libusb_short_write ||
+        (mock_libusb_short_write_after >= 0 &&
+         mock_libusb_submit_calls > mock_libusb_short_write_after);
+    int failed = (mock_libusb_transfer_fail_after >= 0 &&
+                  mock_libusb_submit_calls > mock_libusb_transfer_fail_after) ||
+        (mock_libusb_fail_len_above > 0 && transfer->length > mock_libusb_fail_len_above);
+    int stalled = mock_libusb_stall_len_above > 0 &&
+        transfer->length > mock_libusb_stall_len_above;
+
+    MockPendingTransfer *p = &mock_libusb_pending[mock_libusb_pending_count++];
+    p->transfer = transfer;
+    p->status = failed ? (enum libusb_transfer_status)mock_libusb_transfer_status
+                       : LIBUSB_TRANSFER_COMPLETED;
+    if (stalled || mock_libusb_halted) {
+        failed = 1;
+        p->status = LIBUSB_TRANSFER_STALL;
+    }
+    if (failed && p->status == LIBUSB_TRANSFER_STALL) {
+        mock_libusb_halted = 1;
+    }
+    p->actual_length = failed ? 0 : (short_write ? transfer->length - 1 : transfer->length);
+    pthread_cond_broadcast(&mock_libusb_cond);
+    pthread_mutex_unlock(&mock_libusb_lock);
+    return 0;
+}
+
+/* Completes every pending transfer, waiting up to tv for one to arrive. */
+static inline int libusb_handle_events_timeout_completed(
+    void *ctx, struct timeval *tv, int *completed) {
+    (void)ctx; (void)completed;
+    MockPendingTransfer done[MOCK_LIBUSB_MAX_PENDING];
+    int count;
+
+    pthread_mutex_lock(&mock_libusb_lock);
+    if (mock_libusb_pending_count == 0 && !mock_libusb_interrupted &&
+        !mock_libusb_arrival_pending) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += tv->tv_sec;
+        deadline.tv_nsec += tv->tv_usec * 1000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&mock_libusb_cond, &mock_libusb_lock, &deadline);
+    }
+    count = mock_libusb_pending_count;
+    memcpy(done, mock_libusb_pending, sizeof(done[0]) * (size_t)count);
+    mock_libusb_pending_count = 0;
+    mock_libusb_interrupted = 0;
+    libusb_hotplug_callback_fn arrived[MOCK_LIBUSB_MAX_HOTPLUG] = {0};
+    void *arrived_data[MOCK_LIBUSB_MAX_HOTPLUG];
+    if (mock_libusb_arrival_pending) {
+        memcpy(arrived, mock_libusb_hotplug_cb, sizeof(arrived));
+        memcpy(arrived_data, mock_libusb_hotplug_user_data, sizeof(arrived_data));
+    }
+    mock_libusb_arrival_pending = 0;
+    pthread_mutex_unlock(&mock_libusb_lock);
 
-    if (mock_libusb_bulk_fail_after >= 0 &&
-        mock_libusb_bulk_calls > mock_libusb_bulk_fail_after) {
-        if (transferred) {
-            *transferred = 0;
+    for (int i = 0; i < MOCK_LIBUSB_MAX_HOTPLUG; i++) {
+        if (arrived[i]) {
+            arrived[i](NULL, &mock_libusb_devices[0], LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED,
+                       arrived_data[i]);
         }
-        return (mock_libusb_bulk_transfer_rc != 0) ? mock_libusb_bulk_transfer_rc : -1;
     }
 
-    int short_write = mock_libusb_bulk_short_write ||
-        (mock_libusb_bulk_short_write_after >= 0 &&
-         mock_libusb_bulk_calls > mock_libusb_bulk_short_write_after);
+    for (int i = 0; i < count; i++) {
+        done[i].transfer->status = done[i].status;
+        done[i].transfer->actual_length = done[i].actual_length;
+        done[i].transfer->callback(done[i].transfer);
+    }
+    return 0;
+}
+
+static inline void libusb_interrupt_event_handler(void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&mock_libusb_lock);
+    mock_libusb_interrupted = 1;
+    pthread_cond_broadcast(&mock_libusb_cond);
+    pthread_mutex_unlock(&mock_libusb_lock);
+}
+
+static inline int libusb_has_capability(uint32_t capability) {
+    return capability == LIBUSB_CAP_HAS_HOTPLUG && mock_libusb_hotplug_supported;
+}
+
+static inline int libusb_hotplug_register_callback(
+    libusb_context *ctx, int events, int flags, int vendor_id, int product_id,
+    int dev_class, libusb_hotplug_callback_fn cb_fn, void *user_data,
+    libusb_hotplug_callback_handle *callback_handle) {
+    (void)ctx; (void)events; (void)flags; (void)vendor_id; (void)product_id; (void)dev_class;
+    if (mock_libusb_hotplug_register_rc != 0) {
+        return mock_libusb_hotplug_register_rc;
+    }
+    pthread_mutex_lock(&mock_libusb_lock);
+    int slot = mock_libusb_hotplug_count++;
+    mock_libusb_hotplug_cb[slot] = cb_fn;
+    mock_libusb_hotplug_user_data[slot] = user_data;
+    pthread_mutex_unlock(&mock_libusb_lock);
+    *callback_handle = slot;
+    return 0;
+}
+
+static inline void libusb_hotplug_deregister_callback(
+    libusb_context *ctx, libusb_hotplug_callback_handle callback_handle) {
+    (void)ctx;
+    pthread_mutex_lock(&mock_libusb_lock);
+    mock_libusb_hotplug_cb[callback_handle] = NULL;
+    pthread_mutex_unlock(&mock_libusb_lock);
+}
+
+/* Pull every panel: in-flight and future transfers fail, listing skips them. */
+static inline void mock_libusb_unplug(void) {
+    pthread_mutex_lock(&mock_libusb_lock);
+    for (int i = 0; i < mock_libusb_device_count; i++) {
+        mock_libusb_devices[i].present = 0;
+    }
+    for (int i = 0; i < mock_libusb_pending_count; i++) {
+        mock_libusb_pending[i].status = LIBUSB_TRANSFER_NO_DEVICE;
+        mock_libusb_pending[i].actual_length = 0;
+    }
+    pthread_mutex_unlock(&mock_libusb_lock);
+}
 
-    if (transferred) {
-        *transferred = short_write ? (length - 1) : length;
+/* Plug them back in; registered hotplug callbacks fire from the event loop. */
+static inline void mock_libusb_replug(void) {
+    pthread_mutex_lock(&mock_libusb_lock);
+    for (int i = 0; i < mock_libusb_device_count; i++) {
+        mock_libusb_devices[i].present = 1;
     }
-    return mock_libusb_bulk_transfer_rc;
+    mock_libusb_arrival_pending = 1;
+    pthread_cond_broadcast(&mock_libusb_cond);
+    pthread_mutex_unlock(&mock_libusb_lock);
 }
 
 static inline const char *libusb_error_name(int code) {
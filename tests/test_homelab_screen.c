@@ -8,7 +8,9 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -42,6 +44,18 @@ static int libc_nanosleep(const struct timespec *req, struct timespec *rem) {
 static int libc_vsnprintf(char *str, size_t size, const char *fmt, va_list ap) {
     return vsnprintf(str, size, fmt, ap);
 }
+static int libc_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                               void *(*start)(void *), void *arg) {
+    return pthread_create(thread, attr, start, arg);
+}
+static int libc_posix_memalign(void **ptr, size_t align, size_t size) {
+    return posix_memalign(ptr, align, size);
+}
+static void *libc_malloc(size_t size) { return malloc(size); }
+static int libc_open(const char *path, int flags) { return open(path, flags); }
+static ssize_t libc_pread(int fd, void *buf, size_t len, off_t off) { return pread(fd, buf, len, off); }
+static int libc_close(int fd) { return close(fd); }
+static long libc_sysconf(int name) { return sysconf(name); }
 
 /* ===== test double state ===== */
 
@@ -83,6 +97,10 @@ static MockProc g_mock_procs[MAX_MOCK_PROCS];
 static MockAccess g_mock_access[MAX_MOCK_ACCESS];
 
 static int g_mock_fs_enabled = 0;
+#define MAX_MOCK_FDS 1024
+static char g_mock_fd_path[MAX_MOCK_FDS][256]; /* mock file behind each fd opened from the mocks */
+static int g_mock_open_calls = 0;
+static int g_mock_pread_errno = 0; /* fail the next pread of a mock file once with this */
 static int g_mock_proc_enabled = 0;
 static int g_mock_access_enabled = 0;
 static int g_mock_hostname_enabled = 0;
@@ -105,6 +123,13 @@ static int g_mock_snprintf_fail_enabled = 0;
 static int g_mock_snprintf_fail_once = 0;
 static char g_mock_snprintf_fail_substr[128] = "";
 
+static int g_mock_pthread_create_fail = 0;
+/* Main-loop tests collect inline, in step with the mocked clock and files. */
+static int g_mock_collector_thread = 0;
+static int g_mock_posix_memalign_fail = 0;
+static int g_mock_malloc_fail = 0;
+static long g_mock_nprocs = 0; /* 0: the host's */
+
 static int g_expect_exit = 0;
 static int g_exit_called = 0;
 static int g_exit_code = -1;
@@ -130,7 +155,7 @@ static FILE *make_read_stream(const char *content) {
 }
 
 static FILE *test_fopen(const char *path, const char *mode) {
-    if (!g_mock_fs_enabled) {
+    if (!g_mock_fs_enabled || mode[0] == 'w') { /* the mocks stand in for /proc and /sys only */
         return libc_fopen(path, mode);
     }
 
@@ -146,6 +171,57 @@ static FILE *test_fopen(const char *path, const char *mode) {
     return NULL;
 }
 
+static const MockFile *mock_find_file(const char *path) {
+    for (int i = 0; i < MAX_MOCK_FILES; i++) {
+        if (g_mock_files[i].enabled && strcmp(g_mock_files[i].path, path) == 0) {
+            return &g_mock_files[i];
+        }
+    }
+    return NULL;
+}
+
+/* Mock files open as /dev/null descriptors whose reads serve the current mock content. */
+static int test_open(const char *path, int flags, ...) {
+    if (!g_mock_fs_enabled) {
+        return libc_open(path, flags);
+    }
+    g_mock_open_calls++;
+    const MockFile *mf = mock_find_file(path);
+    if (!mf || mf->fail_open) {
+        errno = ENOENT;
+        return -1;
+    }
+    int fd = libc_open("/dev/null", O_RDONLY);
+    if (fd >= 0 && fd < MAX_MOCK_FDS) {
+        snprintf(g_mock_fd_path[fd], sizeof(g_mock_fd_path[fd]), "%s", path);
+    }
+    return fd;
+}
+
+static ssize_t test_pread(int fd, void *buf, size_t len, off_t off) {
+    if (fd < 0 || fd >= MAX_MOCK_FDS || g_mock_fd_path[fd][0] == '\0') {
+        return libc_pread(fd, buf, len, off);
+    }
+    if (g_mock_pread_errno) {
+        errno = g_mock_pread_errno;
+        g_mock_pread_errno = 0;
+        return -1;
+    }
+    const MockFile *mf = mock_find_file(g_mock_fd_path[fd]);
+    size_t n = mf ? strlen(mf->content) : 0;
+    n = (size_t)off < n ? n - (size_t)off : 0;
+    if (n > len) n = len;
+    if (n) memcpy(buf, mf->content + off, n);
+    return (ssize_t)n;
+}
+
+static int test_close(int fd) {
+    if (fd >= 0 && fd < MAX_MOCK_FDS) {
+        g_mock_fd_path[fd][0] = '\0';
+    }
+    return libc_close(fd);
+}
+
 static DIR *test_opendir(const char *path) {
     if (g_use_mock_net_dir && strcmp(path, "/sys/class/net") == 0) {
         return libc_opendir(g_mock_net_dir);
@@ -310,6 +386,37 @@ static int test_snprintf(char *str, size_t size, const char *fmt, ...) {
     return rc;
 }
 
+static void *collector_thread(void *arg);
+
+static int test_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                               void *(*start)(void *), void *arg) {
+    if (g_mock_pthread_create_fail || (start == collector_thread && !g_mock_collector_thread)) {
+        return EAGAIN;
+    }
+    return libc_pthread_create(thread, attr, start, arg);
+}
+
+static int test_posix_memalign(void **ptr, size_t align, size_t size) {
+    if (g_mock_posix_memalign_fail) {
+        return ENOMEM;
+    }
+    return libc_posix_memalign(ptr, align, size);
+}
+
+static void *test_malloc(size_t size) {
+    if (g_mock_malloc_fail) {
+        return NULL;
+    }
+    return libc_malloc(size);
+}
+
+static long test_sysconf(int name) {
+    if (name == _SC_NPROCESSORS_CONF && g_mock_nprocs) {
+        return g_mock_nprocs;
+    }
+    return libc_sysconf(name);
+}
+
 __attribute__((noreturn))
 static void test_exit(int code) {
     g_exit_called = 1;
@@ -338,9 +445,20 @@ static void test_exit(int code) {
 #endif
 #define snprintf test_snprintf
 #define exit test_exit
+#define pthread_create test_pthread_create
+#define posix_memalign test_posix_memalign
+#define malloc test_malloc
+#define open test_open
+#define pread test_pread
+#define close test_close
+#define sysconf test_sysconf
 
 #include "../homelab-screen.c"
 
+#undef sysconf
+#undef malloc
+#undef posix_memalign
+#undef pthread_create
 #undef exit
 #undef snprintf
 #undef sigaction
@@ -421,13 +539,30 @@ static int write_file(const char *path, const char *content) {
     return 0;
 }
 
+static uint16_t g_test_fb[LCD_W * LCD_H];
+static Surface g_test_surface;
+
+/* Forget every retained frame; the next page into any surface is drawn in full. */
+static void forget_render_targets(void) {
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        target_forget(&g_targets[i]);
+    }
+}
+
+/* Whole-screen surface over the current framebuffer. */
+static Surface *test_surface(void) {
+    g_test_surface = surface_wrap(framebuffer, LCD_W, LCD_H, LCD_W);
+    return &g_test_surface;
+}
+
 static void clear_fb(void) {
-    memset(framebuffer, 0, sizeof(framebuffer));
+    memset(framebuffer, 0, FRAME_SIZE);
+    forget_render_targets();
 }
 
 static int fb_has_color(uint16_t color) {
     for (int i = 0; i < LCD_W * LCD_H; i++) {
-        if (framebuffer[i] == color) {
+        if (le16toh(framebuffer[i]) == color) {
             return 1;
         }
     }
@@ -443,6 +578,21 @@ static int fb_has_any_nonzero(void) {
     return 0;
 }
 
+/* Whether two files hold the same bytes; missing files never match. */
+static int files_equal(const char *a, const char *b) {
+    FILE *fa = libc_fopen(a, "rb");
+    FILE *fb = libc_fopen(b, "rb");
+    int same = fa && fb;
+    while (same) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        same = ca == cb;
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
 static void mock_set_file(const char *path, const char *content, int fail_open) {
     for (int i = 0; i < MAX_MOCK_FILES; i++) {
         if (!g_mock_files[i].enabled) {
@@ -512,11 +662,18 @@ static void reset_test_state(void) {
     g_pid = 0x5302;
     g_interval = 7;
     g_cli_iface[0] = '\0';
-
-    memset(framebuffer, 0, sizeof(framebuffer));
+    g_chunk_size = TRANSFER_SIZE;
+    g_keepalive = 5;
+    g_palette_mode = 0;
+    g_render_dir[0] = '\0';
+    g_snapshot = 0;
     g_running = 1;
+    g_stats_requested = 0;
 
+    collector_stop();
+    metrics_update(); /* drop a snapshot left by the previous test */
     memset(&g_metrics, 0, sizeof(g_metrics));
+    memset(&g_sample, 0, sizeof(g_sample));
     last_net_rx = 0;
     last_net_tx = 0;
     last_net_time = 0;
@@ -524,16 +681,27 @@ static void reset_test_state(void) {
     last_cpu_total = 0;
 
     memset(&g_pve_metrics, 0, sizeof(g_pve_metrics));
+    memset(&g_pve_sample, 0, sizeof(g_pve_sample));
     last_pve_collect = 0;
 
-    dev_handle = NULL;
-    g_ep_out = 0x02;
-    g_usb_iface = -1;
+    usb_transport_stop();
+    for (int i = 0; i < MAX_PANELS; i++) {
+        usb_close_device(&g_panels[i]);
+        usb_free_buffers(&g_panels[i]);
+    }
+    g_panel_count = 0;
+    g_num_panels = 0;
+    g_panel = &g_panels[0];
+    framebuffer = g_test_fb; /* render target for tests that never open a panel */
 
     optind = 1;
     mock_libusb_reset();
+    memset(framebuffer, 0, FRAME_SIZE);
 
+    metrics_close();
     memset(g_mock_files, 0, sizeof(g_mock_files));
+    g_mock_open_calls = 0;
+    g_mock_pread_errno = 0;
     memset(g_mock_cmds, 0, sizeof(g_mock_cmds));
     memset(g_mock_procs, 0, sizeof(g_mock_procs));
     memset(g_mock_access, 0, sizeof(g_mock_access));
@@ -560,6 +728,12 @@ static void reset_test_state(void) {
     g_mock_snprintf_fail_once = 0;
     g_mock_snprintf_fail_substr[0] = '\0';
 
+    g_mock_pthread_create_fail = 0;
+    g_mock_collector_thread = 0;
+    g_mock_posix_memalign_fail = 0;
+    g_mock_malloc_fail = 0;
+    g_mock_nprocs = 0;
+
     g_expect_exit = 0;
     g_exit_called = 0;
     g_exit_code = -1;
@@ -581,52 +755,206 @@ static void reset_test_state(void) {
 
 TEST(set_pixel_valid) {
     clear_fb();
-    set_pixel(0, 0, 0x1234);
-    ASSERT_EQ(framebuffer[0], 0x1234);
-    set_pixel(100, 50, 0xABCD);
-    ASSERT_EQ(framebuffer[50 * LCD_W + 100], 0xABCD);
+    set_pixel(test_surface(), 0, 0, 0x1234);
+    ASSERT_EQ(le16toh(framebuffer[0]), 0x1234);
+    ASSERT_EQ(((uint8_t *)framebuffer)[0], 0x34); /* device byte order */
+    ASSERT_EQ(((uint8_t *)framebuffer)[1], 0x12);
+    set_pixel(test_surface(), 100, 50, 0xABCD);
+    ASSERT_EQ(le16toh(framebuffer[50 * LCD_W + 100]), 0xABCD);
 }
 
 TEST(set_pixel_out_of_bounds) {
     clear_fb();
-    set_pixel(-1, 0, 0xFFFF);
-    set_pixel(0, -1, 0xFFFF);
-    set_pixel(LCD_W, 0, 0xFFFF);
-    set_pixel(0, LCD_H, 0xFFFF);
-    ASSERT_EQ(framebuffer[0], 0x0000);
+    set_pixel(test_surface(), -1, 0, 0xFFFF);
+    set_pixel(test_surface(), 0, -1, 0xFFFF);
+    set_pixel(test_surface(), LCD_W, 0, 0xFFFF);
+    set_pixel(test_surface(), 0, LCD_H, 0xFFFF);
+    ASSERT_EQ(le16toh(framebuffer[0]), 0x0000);
 }
 
 TEST(fill_rect_clipping) {
     clear_fb();
-    fill_rect(-3, -3, 5, 5, 0x3333);
-    ASSERT_EQ(framebuffer[0], 0x3333);
-    ASSERT_EQ(framebuffer[2], 0x0000);
+    fill_rect(test_surface(), -3, -3, 5, 5, 0x3333);
+    ASSERT_EQ(le16toh(framebuffer[0]), 0x3333);
+    ASSERT_EQ(le16toh(framebuffer[2]), 0x0000);
 
     clear_fb();
-    fill_rect(LCD_W - 2, LCD_H - 2, 10, 10, 0x2222);
-    ASSERT_EQ(framebuffer[(LCD_H - 1) * LCD_W + (LCD_W - 1)], 0x2222);
+    fill_rect(test_surface(), LCD_W - 2, LCD_H - 2, 10, 10, 0x2222);
+    ASSERT_EQ(le16toh(framebuffer[(LCD_H - 1) * LCD_W + (LCD_W - 1)]), 0x2222);
+
+    clear_fb();
+    fill_rect(test_surface(), LCD_W + 1, 0, 10, 10, 0x4444);
+    fill_rect(test_surface(), 10, 10, -5, 3, 0x4444);
+    ASSERT(!fb_has_any_nonzero());
+}
+
+/* Every vector kernel the CPU supports must match the scalar reference. */
+TEST(pixel_kernels_match_scalar) {
+    static uint16_t ref[LCD_W * LCD_H + 32];
+    static uint16_t out[LCD_W * LCD_H + 32];
+    const PixelKernels *scalar = &pixel_kernel_table[
+        sizeof(pixel_kernel_table) / sizeof(pixel_kernel_table[0]) - 1];
+    int checked = 0;
+
+    ASSERT_STREQ(scalar->name, "scalar");
+    ASSERT(pixel_kernels() == pixel_kernels());
+    ASSERT_STREQ(pixel_kernels_name(), pixel_kernel_table[0].name);
+
+    for (size_t i = 0; i < sizeof(out) / sizeof(out[0]); i++) {
+        out[i] = (uint16_t)(i * 2654435761u >> 7);
+    }
+    for (const PixelKernels *k = pixel_kernel_table; k <= scalar; k++) {
+        if (!k->supported()) continue;
+        checked++;
+
+        for (size_t off = 0; off < 3; off++) {
+            for (size_t n = 0; n < 70; n += 1 + n / 8) {
+                memcpy(ref, out, sizeof(ref));
+                fill16_scalar(ref + off, 0xA5C3, n);
+                k->fill16(out + off, 0xA5C3, n);
+                ASSERT_EQ(memcmp(ref, out, sizeof(ref)), 0);
+            }
+        }
+        k->fill16(out + 1, 0x1234, LCD_W * LCD_H);
+        fill16_scalar(ref + 1, 0x1234, LCD_W * LCD_H);
+        ASSERT_EQ(memcmp(ref, out, sizeof(ref)), 0);
+
+        for (size_t i = 0; i < sizeof(out) / sizeof(out[0]); i++) {
+            out[i] = (uint16_t)(i * 40503u ^ (i >> 3));
+        }
+        for (size_t len = 0; len <= 256; len += 32) {
+            ASSERT_EQ(k->hash64(out + 3, len), hash64_scalar(out + 3, len));
+        }
+        ASSERT_EQ(k->hash64(out, FRAME_SIZE), hash64_scalar(out, FRAME_SIZE));
+
+        static uint8_t idx[LCD_W * LCD_H + 32];
+        static const int lut_sizes[] = {1, 12, 16, 17, 256};
+        uint16_t lut[256];
+        for (int i = 0; i < 256; i++) {
+            lut[i] = (uint16_t)(i * 40503u + 7);
+        }
+        for (size_t z = 0; z < sizeof(lut_sizes) / sizeof(lut_sizes[0]); z++) {
+            for (size_t i = 0; i < sizeof(idx); i++) {
+                idx[i] = (uint8_t)((i * 7 + i / 5) % lut_sizes[z]);
+            }
+            for (size_t off = 0; off < 3; off++) {
+                for (size_t n = 0; n < 70; n += 1 + n / 8) {
+                    memcpy(ref, out, sizeof(ref));
+                    expand8_scalar(ref + off, idx + off, lut, lut_sizes[z], n);
+                    k->expand8(out + off, idx + off, lut, lut_sizes[z], n);
+                    ASSERT_EQ(memcmp(ref, out, sizeof(ref)), 0);
+                }
+            }
+            k->expand8(out + 1, idx + 3, lut, lut_sizes[z], LCD_W * LCD_H);
+            expand8_scalar(ref + 1, idx + 3, lut, lut_sizes[z], LCD_W * LCD_H);
+            ASSERT_EQ(memcmp(ref, out, sizeof(ref)), 0);
+        }
+    }
+    ASSERT(checked >= 1);
+}
+
+/* The per-pixel rounded rectangle the corner span tables replaced. */
+static void draw_rounded_rect_pixels(int x, int y, int w, int h, int r, uint16_t color) {
+    fill_rect(test_surface(), x + r, y, w - 2*r, h, color);
+    fill_rect(test_surface(), x, y + r, r, h - 2*r, color);
+    fill_rect(test_surface(), x + w - r, y + r, r, h - 2*r, color);
+    for (int cy = 0; cy < r; cy++) {
+        for (int cx = 0; cx < r; cx++) {
+            int dx = r - 1 - cx;
+            int dy = r - 1 - cy;
+            if (dx*dx + dy*dy <= r*r) {
+                set_pixel(test_surface(), x + cx, y + cy, color);
+                set_pixel(test_surface(), x + w - 1 - cx, y + cy, color);
+                set_pixel(test_surface(), x + cx, y + h - 1 - cy, color);
+                set_pixel(test_surface(), x + w - 1 - cx, y + h - 1 - cy, color);
+            }
+        }
+    }
+}
+
+TEST(rounded_rect_spans_match_pixels) {
+    static uint16_t expect[LCD_W * LCD_H];
+    const int rects[][5] = {
+        {10, 90, LCD_W - 20, 90, 8}, {10, 200, 107, 55, 6}, {20, 160, 200, 10, 5},
+        {22, 162, 5, 6, 3}, {22, 162, 1, 1, 3}, {-4, -3, 30, 20, 7}, {LCD_W - 15, LCD_H - 12, 40, 40, 12},
+        {30, 30, 100, 100, 0}, {30, 30, 100, 100, -2}, {5, 5, 120, 120, CORNER_MAX_RADIUS},
+        {5, 5, 150, 150, CORNER_MAX_RADIUS + 8}
+    };
+
+    for (size_t i = 0; i < sizeof(rects) / sizeof(rects[0]); i++) {
+        const int *q = rects[i];
+        clear_fb();
+        draw_rounded_rect_pixels(q[0], q[1], q[2], q[3], q[4], 0x4208);
+        memcpy(expect, framebuffer, FRAME_SIZE);
+        clear_fb();
+        draw_rounded_rect(test_surface(), q[0], q[1], q[2], q[3], q[4], 0x4208);
+        ASSERT(memcmp(expect, framebuffer, FRAME_SIZE) == 0);
+    }
+    ASSERT(g_corner_built[8]);
+    ASSERT_EQ(g_corner_insets[8][7], 0); /* last corner row is full width */
+}
+
+/* The per-pixel glyph loop the span cache replaced, kept as the reference. */
+static void draw_char_bitwise(int x, int y, char c, uint16_t color, int scale) {
+    if (c < 0x20 || c > 0x7E) c = '?';
+    int idx = c - 0x20;
+    for (int row = 0; row < 16; row++) {
+        uint8_t bits = font8x16[idx][row];
+        for (int col = 0; col < 8; col++) {
+            if (bits & (0x80 >> col)) {
+                for (int sy = 0; sy < scale; sy++) {
+                    for (int sx = 0; sx < scale; sx++) {
+                        set_pixel(test_surface(), x + col*scale + sx, y + row*scale + sy, color);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(glyph_spans_match_bitmap) {
+    static uint16_t expect[LCD_W * LCD_H];
+    const int pos[][2] = {
+        {3, 5}, {-5, -7}, {LCD_W - 10, LCD_H - 20}, {LCD_W, 0}, {-100, 0}, {0, LCD_H}, {0, -100}
+    };
+
+    for (int scale = 0; scale <= GLYPH_MAX_SCALE + 2; scale++) {
+        for (size_t p = 0; p < sizeof(pos) / sizeof(pos[0]); p++) {
+            for (int c = 0x1F; c <= 0x7E; c++) {
+                clear_fb();
+                draw_char_bitwise(pos[p][0], pos[p][1], (char)c, 0x7BEF, scale);
+                memcpy(expect, framebuffer, FRAME_SIZE);
+                clear_fb();
+                draw_char(test_surface(), pos[p][0], pos[p][1], (char)c, 0x7BEF, scale);
+                ASSERT(memcmp(expect, framebuffer, FRAME_SIZE) == 0);
+            }
+        }
+    }
+    ASSERT(g_glyph_cache[0].built);
+    ASSERT_EQ(g_glyph_cache[0].first[0], 0); /* space has no spans */
+    ASSERT_EQ(g_glyph_cache[0].first[1], 0);
 }
 
 TEST(draw_char_and_strings) {
     clear_fb();
-    draw_char(0, 0, '!', 0xAAAA, 1);
-    ASSERT_EQ(framebuffer[2 * LCD_W + 3], 0xAAAA);
+    draw_char(test_surface(), 0, 0, '!', 0xAAAA, 1);
+    ASSERT_EQ(le16toh(framebuffer[2 * LCD_W + 3]), 0xAAAA);
 
     clear_fb();
-    draw_char(0, 0, '\x01', 0xBBBB, 1);
-    ASSERT_EQ(framebuffer[2 * LCD_W + 2], 0xBBBB);
+    draw_char(test_surface(), 0, 0, '\x01', 0xBBBB, 1);
+    ASSERT_EQ(le16toh(framebuffer[2 * LCD_W + 2]), 0xBBBB);
 
     clear_fb();
-    draw_char(0, 0, '!', 0xCCCC, 2);
-    ASSERT_EQ(framebuffer[4 * LCD_W + 6], 0xCCCC);
+    draw_char(test_surface(), 0, 0, '!', 0xCCCC, 2);
+    ASSERT_EQ(le16toh(framebuffer[4 * LCD_W + 6]), 0xCCCC);
 
     clear_fb();
-    draw_string(0, 0, "AB", 0x1111, 1);
-    ASSERT_EQ(framebuffer[2 * LCD_W + 4], 0x1111);
+    draw_string(test_surface(), 0, 0, "AB", 0x1111, 1);
+    ASSERT_EQ(le16toh(framebuffer[2 * LCD_W + 4]), 0x1111);
 
     clear_fb();
-    draw_string_centered(0, "AB", 0x1234, 1);
-    ASSERT_EQ(framebuffer[2 * LCD_W + 116], 0x1234);
+    draw_string_centered(test_surface(), 0, "AB", 0x1234, 1);
+    ASSERT_EQ(le16toh(framebuffer[2 * LCD_W + 116]), 0x1234);
 
     ASSERT_EQ(string_width("", 1), 0);
     ASSERT_EQ(string_width("AB", 2), 32);
@@ -634,19 +962,64 @@ TEST(draw_char_and_strings) {
 
 TEST(progress_and_circle) {
     clear_fb();
-    draw_progress_bar(10, 10, 100, 10, 0.0f, 0x0001, 0x0002);
+    draw_progress_bar(test_surface(), 10, 10, 100, 10, 0.0f, 0x0001, 0x0002);
     ASSERT(fb_has_color(0x0001));
 
     clear_fb();
-    draw_progress_bar(10, 10, 100, 10, 100.0f, 0x0001, 0x0002);
+    draw_progress_bar(test_surface(), 10, 10, 100, 10, 100.0f, 0x0001, 0x0002);
     ASSERT(fb_has_color(0x0002));
 
     clear_fb();
-    draw_circle_progress(60, 60, 20, 5, 50.0f, 0x0003, 0x0004);
+    draw_circle_progress(test_surface(), 60, 60, 20, 5, 50.0f, 0x0003, 0x0004);
     ASSERT(fb_has_color(0x0003));
     ASSERT(fb_has_color(0x0004));
 }
 
+/* The per-pixel trig gauge the ring tables replaced, kept as the reference. */
+static void draw_circle_progress_trig(int cx, int cy, int radius, int thickness, float pct,
+                                      uint16_t bg_color, uint16_t fg_color) {
+    float angle_max = (pct / 100.0f) * 2.0f * M_PI;
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            float dist = sqrtf(x*x + y*y);
+            if (dist >= radius - thickness && dist <= radius) {
+                float angle = atan2f(-x, -y) + M_PI;
+                set_pixel(test_surface(), cx + x, cy + y, (angle <= angle_max) ? fg_color : bg_color);
+            }
+        }
+    }
+}
+
+TEST(circle_progress_matches_trig_reference) {
+    static uint16_t expect[LCD_W * LCD_H];
+    const float pcts[] = {0.0f, 0.1f, 12.5f, 50.0f, 73.3f, 99.9f, 100.0f};
+    const int shapes[][4] = {{120, 155, 85, 14}, {5, 310, 20, 5}};
+
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+            const int *g = shapes[s];
+            clear_fb();
+            draw_circle_progress_trig(g[0], g[1], g[2], g[3], pcts[i], 0x0841, 0x2D7F);
+            memcpy(expect, framebuffer, FRAME_SIZE);
+            clear_fb();
+            draw_circle_progress(test_surface(), g[0], g[1], g[2], g[3], pcts[i], 0x0841, 0x2D7F);
+            ASSERT(memcmp(expect, framebuffer, FRAME_SIZE) == 0);
+        }
+    }
+
+    /* More shapes than cache entries recycle the last one. */
+    for (int r = 10; r < 10 + RING_CACHE_SIZE + 1; r++) {
+        draw_circle_progress(test_surface(), 60, 60, r, 3, 50.0f, 0x0001, 0x0002);
+    }
+    ASSERT_EQ(g_rings[RING_CACHE_SIZE - 1].radius, 10 + RING_CACHE_SIZE);
+
+    /* Without memory for the table the gauge is skipped. */
+    clear_fb();
+    g_mock_malloc_fail = 1;
+    draw_circle_progress(test_surface(), 60, 60, 30, 3, 50.0f, 0x0001, 0x0002);
+    ASSERT(!fb_has_any_nonzero());
+}
+
 TEST(format_bytes_helpers) {
     char buf[32];
 
@@ -713,76 +1086,390 @@ TEST(render_pages_all_paths) {
     g_pve_metrics.storage[3].total_bytes = 100ULL * 1024 * 1024 * 1024;
 
     clear_fb();
-    render_page_overview();
+    render_page_overview(test_surface());
     ASSERT(fb_has_any_nonzero());
     ASSERT(fb_has_color(0xFFFF));
 
     clear_fb();
-    render_page_cpu();
+    render_page_cpu(test_surface());
     ASSERT(fb_has_any_nonzero());
     ASSERT(fb_has_color(0xF800));
 
     g_metrics.cpu_temp = 0.0f;
     clear_fb();
-    render_page_cpu();
+    render_page_cpu(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_metrics.mem_pct = 80.0f;
     clear_fb();
-    render_page_memory();
+    render_page_memory(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_metrics.mem_pct = 20.0f;
     clear_fb();
-    render_page_memory();
+    render_page_memory(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     clear_fb();
-    render_page_network();
+    render_page_network(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_metrics.uptime_secs = 3600 + 120;
     clear_fb();
-    render_page_system();
+    render_page_system(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_metrics.uptime_secs = 3 * 86400 + 3600;
     clear_fb();
-    render_page_system();
+    render_page_system(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_mock_localtime_force_null = 1;
     g_mock_localtime_null_once = 1;
     clear_fb();
-    render_page_system();
+    render_page_system(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     clear_fb();
-    render_page_proxmox();
+    render_page_proxmox(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_pve_metrics.pve_version[0] = '\0';
     clear_fb();
-    render_page_proxmox();
+    render_page_proxmox(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     clear_fb();
-    render_page_storage();
+    render_page_storage(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_pve_metrics.storage_count = 0;
     clear_fb();
-    render_page_storage();
+    render_page_storage(test_surface());
     ASSERT(fb_has_any_nonzero());
 
     g_metrics.cpu_temp = 0.0f;
     clear_fb();
-    render_page_overview();
+    render_page_overview(test_surface());
     ASSERT(fb_has_any_nonzero());
 }
 
 /* ===== CLI ===== */
 
+/* Two metric sets that differ in every widget of every page; names stay. */
+static void set_widget_metrics(int variant) {
+    g_metrics.cpu_usage = variant ? 95.0f : 7.0f;
+    g_metrics.cpu_temp = variant ? 85.0f : 0.0f;
+    g_metrics.mem_pct = variant ? 93.0f : 40.0f;
+    g_metrics.mem_used = (variant ? 15ULL : 6ULL) * 1024 * 1024 * 1024;
+    g_metrics.mem_total = 16ULL * 1024 * 1024 * 1024;
+    g_metrics.net_rx_rate = variant ? 120000000.0f : 2048.0f;
+    g_metrics.net_tx_rate = variant ? 900.0f : 60000000.0f;
+    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "vmbr0");
+    snprintf(g_metrics.hostname, sizeof(g_metrics.hostname), "node-a");
+    g_metrics.uptime_secs = variant ? 3 * 86400 + 3600 : 4000;
+    g_metrics.load_1 = variant ? 12.5f : 0.1f;
+    g_metrics.core_count = 64;
+    for (int i = 0; i < 64; i++) {
+        g_metrics.core_pct[i] = (uint8_t)(variant ? i * 37 % 101 : i * 7 % 40);
+    }
+    g_pve_metrics.running_vms = variant ? 12 : 3;
+    g_pve_metrics.total_vms = 12;
+    g_pve_metrics.running_cts = variant ? 0 : 5;
+    g_pve_metrics.total_cts = variant ? 7 : 10;
+    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "pve-node");
+    snprintf(g_pve_metrics.pve_version, sizeof(g_pve_metrics.pve_version), "%s", variant ? "pve-manager/8.3.0" : "");
+    g_pve_metrics.storage_count = 2;
+    for (int i = 0; i < 2; i++) {
+        snprintf(g_pve_metrics.storage[i].name, sizeof(g_pve_metrics.storage[i].name), "%s%d",
+                 variant ? "tank" : "local", i);
+        g_pve_metrics.storage[i].used_pct = variant ? 95.0f - i * 30.0f : 10.0f;
+        g_pve_metrics.storage[i].used_bytes = (variant ? 95ULL : 10ULL) * 1024 * 1024 * 1024;
+        g_pve_metrics.storage[i].total_bytes = 100ULL * 1024 * 1024 * 1024;
+    }
+    g_mock_time_enabled = 1;
+    g_mock_times[0] = variant ? 1700000000 : 1700090000;
+    g_mock_time_count = 1;
+    g_mock_time_idx = 0;
+}
+
+/* Render a page into fb from scratch, leaving every retained frame as it was. */
+static void render_fresh(void (*page)(Surface *s), uint16_t *fb) {
+    static RenderTarget saved[RENDER_TARGETS];
+    memcpy(saved, g_targets, sizeof(saved));
+    forget_render_targets();
+    memset(fb, 0, FRAME_SIZE);
+    Surface s = surface_wrap(fb, LCD_W, LCD_H, LCD_W);
+    page(&s);
+    memcpy(g_targets, saved, sizeof(saved));
+}
+
+TEST(render_damage_matches_full_redraw) {
+    static uint16_t other_fb[LCD_W * LCD_H];
+    static uint16_t expect[LCD_W * LCD_H];
+    void (*pages[])(Surface *s) = {
+        render_page_overview, render_page_cpu, render_page_cores, render_page_memory,
+        render_page_network, render_page_system, render_page_proxmox, render_page_storage,
+    };
+    const int sequence[] = {0, 1, 1, 0};
+
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); p++) {
+        set_widget_metrics(0);
+        clear_fb();
+        pages[p](test_surface());
+        Rect d = render_damage(test_surface());
+        ASSERT(d.x == 0 && d.y == 0 && d.w == LCD_W && d.h == LCD_H);
+
+        /* Unchanged values repaint nothing. */
+        pages[p](test_surface());
+        ASSERT_EQ(render_damage(test_surface()).w, 0);
+
+        for (size_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); i++) {
+            memcpy(expect, g_test_fb, FRAME_SIZE);
+            set_widget_metrics(sequence[i]);
+            pages[p](test_surface());
+            d = render_damage(test_surface());
+            ASSERT(d.w * d.h < LCD_W * LCD_H);
+            ASSERT_EQ(d.w > 0, sequence[i] != (i ? sequence[i - 1] : 0));
+
+            /* Nothing outside the damage was touched... */
+            for (int y = 0; y < LCD_H; y++) {
+                for (int x = 0; x < LCD_W; x++) {
+                    if (x < d.x || x >= d.x + d.w || y < d.y || y >= d.y + d.h) {
+                        ASSERT_EQ(expect[y * LCD_W + x], g_test_fb[y * LCD_W + x]);
+                    }
+                }
+            }
+
+            /* ...and the result is what a full redraw paints. */
+            set_widget_metrics(sequence[i]);
+            render_fresh(pages[p], other_fb);
+            ASSERT(memcmp(g_test_fb, other_fb, FRAME_SIZE) == 0);
+        }
+    }
+
+    /* A different pool count is a different layout: full redraw. */
+    set_widget_metrics(0);
+    g_pve_metrics.storage_count = 3;
+    render_page_storage(test_surface());
+    ASSERT_EQ(render_damage(test_surface()).w * render_damage(test_surface()).h, LCD_W * LCD_H);
+
+    /* Gauges outside the unchecked fast path, and without ring memory. */
+    RenderFrame f;
+    clear_fb();
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    gauge_widget(&f, 5, 310, 20, 5, 30.0f, COLOR_BG_GAUGE, COLOR_CYAN);
+    render_end(&f);
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    gauge_widget(&f, 5, 310, 20, 5, 60.0f, COLOR_BG_GAUGE, COLOR_CYAN);
+    render_end(&f);
+    ASSERT_EQ(render_damage(test_surface()).x, 0);
+    ASSERT_EQ(render_damage(test_surface()).y, 290);
+    ASSERT(fb_has_color(COLOR_CYAN));
+
+    g_mock_malloc_fail = 1;
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    gauge_widget(&f, 60, 60, 33, 3, 50.0f, COLOR_BG_GAUGE, COLOR_CYAN);
+    ASSERT_EQ(f.widgets[0].value, 0);
+    render_end(&f);
+    g_mock_malloc_fail = 0;
+
+    /*
+     * Widgets past the table are drawn directly: the whole frame counts as
+     * damaged and the next one is a full redraw.
+     */
+    clear_fb();
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    render_end(&f);
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    render_end(&f);
+    ASSERT_EQ(render_damage(test_surface()).w, 0);
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    for (int i = 0; i <= RENDER_MAX_WIDGETS; i++) {
+        text_widget(&f, 0, 40 + i, "x", COLOR_WHITE, 1);
+    }
+    render_end(&f);
+    ASSERT_EQ(f.target->layout, -1);
+    ASSERT_EQ(render_damage(test_surface()).w * render_damage(test_surface()).h, LCD_W * LCD_H);
+    render_begin(&f, test_surface(), LAYOUT_CPU, cpu_static, "");
+    render_end(&f);
+    ASSERT_EQ(render_damage(test_surface()).w, LCD_W);
+
+    /* Long text is cut to the widget's buffer. */
+    char long_text[100];
+    memset(long_text, 'a', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    text_widget(&f, 0, 0, long_text, COLOR_WHITE, 1);
+    ASSERT_EQ((int)strlen(f.widgets[0].text), 63);
+
+    /* Buffers beyond the target table recycle the oldest entry. */
+    static uint16_t spare[RENDER_TARGETS + 1];
+    for (int i = 0; i <= RENDER_TARGETS; i++) {
+        Surface sp = surface_wrap(&spare[i], 1, 1, 1);
+        ASSERT_EQ(render_target(&sp)->layout, -1);
+    }
+    int found = 0;
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        found |= g_targets[i].surface.px == g_test_fb;
+    }
+    ASSERT(!found);
+
+    /* A released buffer leaves the table, so no frame is seeded from it. */
+    render_page_cpu(test_surface());
+    ASSERT(render_damage(test_surface()).w > 0);
+    render_release(g_test_fb, FRAME_SIZE);
+    found = 0;
+    for (int i = 0; i < RENDER_TARGETS; i++) {
+        found |= g_targets[i].surface.px == g_test_fb;
+    }
+    ASSERT(!found);
+    ASSERT_EQ(render_damage(test_surface()).w, 0);
+    Surface other = surface_wrap(other_fb, LCD_W, LCD_H, LCD_W);
+    ASSERT(render_peer(render_target(&other), LAYOUT_CPU, "") == NULL);
+}
+
+/* Drop every cached page background, as if none had been drawn yet. */
+static void free_backgrounds(void) {
+    for (int f = 0; f < 2; f++) {
+        for (int i = 0; i < LAYOUT_COUNT; i++) {
+            free((void *)surface_pixels(&g_backgrounds[f][i].surface));
+            g_backgrounds[f][i].surface.px = NULL;
+            g_backgrounds[f][i].surface.idx = NULL;
+            g_backgrounds[f][i].valid = 0;
+        }
+    }
+}
+
+/* Heatmap cells are laid out per core count and repainted one by one. */
+TEST(render_cores_heatmap) {
+    g_metrics.core_count = 4;
+    const uint8_t pct[4] = {0, 50, 100, 5};
+    memcpy(g_metrics.core_pct, pct, sizeof(pct));
+    clear_fb();
+    render_page_cores(test_surface());
+    const HeatmapGrid *g = heatmap_grid(4);
+    ASSERT_EQ(g->size, 108);
+    ASSERT_EQ(g->x[1] - g->x[0], 110);
+    ASSERT_EQ(g->y[2] - g->y[0], 110);
+    ASSERT_EQ(le16toh(g_test_fb[g->y[2] * LCD_W + g->x[2]]), COLOR_RED);
+
+    /* Within a level nothing moves; a new level repaints just that cell. */
+    g_metrics.core_pct[1] = 55;
+    render_page_cores(test_surface());
+    ASSERT_EQ(render_damage(test_surface()).w, 0);
+    g_metrics.core_pct[3] = 70;
+    render_page_cores(test_surface());
+    Rect d = render_damage(test_surface());
+    ASSERT(d.x == g->x[3] && d.y == g->y[3] && d.w == 108 && d.h == 108);
+    ASSERT_EQ(le16toh(g_test_fb[g->y[3] * LCD_W + g->x[3]]), COLOR_YELLOW);
+    ASSERT_EQ(heat_level(0), 0);
+    ASSERT_EQ(heat_level(100), 5);
+
+    /* No per-core data: a note instead of cells, and no busiest core. */
+    g_metrics.core_count = 0;
+    render_page_cores(test_surface());
+    ASSERT_EQ(render_target(test_surface())->cell_count, 0);
+}
+
+TEST(render_backgrounds_follow_names) {
+    static uint16_t expect[LCD_W * LCD_H];
+    struct {
+        void (*render)(Surface *s);
+        char *name;
+        size_t len;
+    } pages[] = {
+        {render_page_network, g_metrics.net_iface, sizeof(g_metrics.net_iface)},
+        {render_page_system, g_metrics.hostname, sizeof(g_metrics.hostname)},
+        {render_page_proxmox, g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name)},
+    };
+
+    set_widget_metrics(0);
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); p++) {
+        snprintf(pages[p].name, pages[p].len, "first");
+        clear_fb();
+        pages[p].render(test_surface());
+        pages[p].render(test_surface());
+        ASSERT_EQ(render_damage(test_surface()).w, 0);
+
+        /* A new name rebuilds the background and repaints the frame. */
+        snprintf(pages[p].name, pages[p].len, "second");
+        pages[p].render(test_surface());
+        ASSERT_EQ(render_damage(test_surface()).w * render_damage(test_surface()).h, LCD_W * LCD_H);
+        memcpy(expect, framebuffer, FRAME_SIZE);
+        clear_fb();
+        free_backgrounds();
+        pages[p].render(test_surface());
+        ASSERT(memcmp(expect, framebuffer, FRAME_SIZE) == 0);
+    }
+
+    /* Without memory for backgrounds the static layer is drawn directly. */
+    free_backgrounds();
+    g_mock_malloc_fail = 1;
+    set_widget_metrics(0);
+    clear_fb();
+    render_page_network(test_surface());
+    set_widget_metrics(1);
+    render_page_network(test_surface());
+    g_mock_malloc_fail = 0;
+    ASSERT(g_backgrounds[0][LAYOUT_NETWORK].surface.px == NULL);
+    memcpy(expect, framebuffer, FRAME_SIZE);
+    clear_fb();
+    render_page_network(test_surface());
+    ASSERT(memcmp(expect, framebuffer, FRAME_SIZE) == 0);
+}
+
+TEST(render_into_offscreen_surface) {
+    enum { PAD = 16, STRIDE = LCD_W + PAD };
+    static uint16_t wide[STRIDE * LCD_H];
+    void (*pages[])(Surface *s) = {
+        render_page_overview, render_page_cpu, render_page_cores, render_page_memory,
+        render_page_network, render_page_system, render_page_proxmox, render_page_storage,
+    };
+
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); p++) {
+        set_widget_metrics(1);
+        clear_fb();
+        pages[p](test_surface());
+
+        /* Offscreen rendering, full and incremental, never uses framebuffer. */
+        forget_render_targets();
+        uint16_t *usb_fb = framebuffer;
+        framebuffer = NULL;
+        for (size_t i = 0; i < sizeof(wide) / sizeof(wide[0]); i++) wide[i] = 0xAAAA;
+        Surface off = surface_wrap(wide, LCD_W, LCD_H, STRIDE);
+        pages[p](&off);
+        set_widget_metrics(0);
+        pages[p](&off);
+        set_widget_metrics(1);
+        pages[p](&off);
+        framebuffer = usb_fb;
+
+        for (int y = 0; y < LCD_H; y++) {
+            ASSERT(memcmp(wide + y * STRIDE, g_test_fb + y * LCD_W, LCD_W * sizeof(uint16_t)) == 0);
+            for (int x = LCD_W; x < STRIDE; x++) {
+                ASSERT_EQ(wide[y * STRIDE + x], 0xAAAA);
+            }
+        }
+    }
+
+    /* Primitives stay inside the clip. */
+    clear_fb();
+    Surface clipped = surface_wrap(g_test_fb, LCD_W, LCD_H, LCD_W);
+    clipped.clip = (Rect){10, 10, 20, 20};
+    fill_rect(&clipped, 0, 0, LCD_W, LCD_H, 0xFFFF);
+    draw_string(&clipped, 0, 0, "WWWWW", 0xF800, 3);
+    set_pixel(&clipped, 5, 5, 0x07E0);
+    int inside = 0;
+    for (int y = 0; y < LCD_H; y++) {
+        for (int x = 0; x < LCD_W; x++) {
+            int in_clip = x >= 10 && x < 30 && y >= 10 && y < 30;
+            ASSERT_EQ(g_test_fb[y * LCD_W + x] != 0, in_clip);
+            inside += in_clip;
+        }
+    }
+    ASSERT_EQ(inside, 400);
+}
+
 TEST(parse_hex_and_int_helpers) {
     uint16_t u16 = 0;
     int iv = 0;
@@ -804,12 +1491,66 @@ TEST(parse_hex_and_int_helpers) {
 }
 
 TEST(parse_args_valid_and_invalid) {
-    char *argv_ok[] = {"homelab-screen", "--vid", "0417", "--pid", "5303", "--interval", "9", "--interface", "eth1", NULL};
-    ASSERT_EQ(parse_args(9, argv_ok), 0);
+    char *argv_ok[] = {"homelab-screen", "--vid", "0417", "--pid", "5303", "--interval", "9", "--interface", "eth1",
+                       "--chunk-size", "4096", NULL};
+    ASSERT_EQ(parse_args(11, argv_ok), 0);
     ASSERT_EQ(g_vid, 0x0417);
     ASSERT_EQ(g_pid, 0x5303);
     ASSERT_EQ(g_interval, 9);
     ASSERT_STREQ(g_cli_iface, "eth1");
+    ASSERT_EQ(g_chunk_size, 4096);
+
+    char *argv_keepalive[] = {"homelab-screen", "--keepalive", "30", NULL};
+    ASSERT_EQ(parse_args(3, argv_keepalive), 0);
+    ASSERT_EQ(g_keepalive, 30);
+
+    char *argv_snapshot[] = {"homelab-screen", "--snapshot", NULL};
+    ASSERT_EQ(parse_args(2, argv_snapshot), 0);
+    ASSERT_EQ(g_snapshot, 1);
+    ASSERT_STREQ(g_render_dir, ".");
+
+    char *argv_render_to[] = {"homelab-screen", "--render-to", "/tmp/frames", NULL};
+    ASSERT_EQ(parse_args(3, argv_render_to), 0);
+    ASSERT_STREQ(g_render_dir, "/tmp/frames");
+
+    char long_dir[300];
+    memset(long_dir, 'd', sizeof(long_dir) - 1);
+    long_dir[sizeof(long_dir) - 1] = '\0';
+    char *argv_bad_render_to[] = {"homelab-screen", "--render-to", long_dir, NULL};
+    ASSERT_EQ(parse_args(3, argv_bad_render_to), -1);
+    g_render_dir[0] = '\0';
+    g_snapshot = 0;
+
+    char *argv_bad_keepalive[] = {"homelab-screen", "--keepalive", "0", NULL};
+    ASSERT_EQ(parse_args(3, argv_bad_keepalive), -1);
+
+    char *argv_devices[] = {"homelab-screen", "--device", "0416:5302", "--device", "87ad:70db@3:007", NULL};
+    ASSERT_EQ(parse_args(5, argv_devices), 0);
+    ASSERT_EQ(g_num_panels, 2);
+    ASSERT_EQ(g_panel_cfg[0].vid, 0x0416);
+    ASSERT_EQ(g_panel_cfg[0].pid, 0x5302);
+    ASSERT_EQ(g_panel_cfg[0].bus, -1);
+    ASSERT_EQ(g_panel_cfg[1].vid, 0x87AD);
+    ASSERT_EQ(g_panel_cfg[1].pid, 0x70DB);
+    ASSERT_EQ(g_panel_cfg[1].bus, 3);
+    ASSERT_EQ(g_panel_cfg[1].addr, 7);
+
+    const char *bad_devices[] = {
+        "0416", "0416:", "zz:5302", "0416:5302@3", "0416:5302@x:1", "0416:5302@1:0",
+        "0416:5302@1:2:3:4:5:6:7:8:9:10:11:12:13"
+    };
+    for (size_t i = 0; i < sizeof(bad_devices) / sizeof(bad_devices[0]); i++) {
+        char *argv_bad_device[] = {"homelab-screen", "--device", (char *)bad_devices[i], NULL};
+        ASSERT_EQ(parse_args(3, argv_bad_device), -1);
+    }
+
+    char *argv_too_many[] = {"homelab-screen", "--device", "1:1", "--device", "1:2", "--device", "1:3", NULL};
+    ASSERT_EQ(parse_args(7, argv_too_many), -1);
+    ASSERT_EQ(g_num_panels, MAX_PANELS);
+    g_num_panels = 0;
+
+    char *argv_bad_chunk[] = {"homelab-screen", "--chunk-size", "1000", NULL};
+    ASSERT_EQ(parse_args(3, argv_bad_chunk), -1);
 
     char *argv_bad_vid[] = {"homelab-screen", "--vid", "ZZZZ", NULL};
     ASSERT_EQ(parse_args(3, argv_bad_vid), -1);
@@ -849,26 +1590,338 @@ TEST(compute_counter_rate_cases) {
     ASSERT_FLOAT_NEAR(compute_counter_rate(100, 100, 0), 0.0f, 0.001f);
 }
 
+/* Every prefix of a real file parses to the true values or not at all. */
+TEST(proc_parsers_on_truncated_input) {
+    static const char stat[] =
+        "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n"
+        "cpu0 1393 280 219 924480 7530 0 186 0 0 0\n"
+        "intr 1462898 33 0 0\n";
+    static const uint64_t stat_fields[7] = {4705, 356, 584, 3699176, 23060, 0, 277};
+    static const char meminfo[] =
+        "MemTotal:       16318852 kB\n"
+        "MemFree:         1234567 kB\n"
+        "MemAvailable:    8000000 kB\n"
+        "Buffers:          400000 kB\n"
+        "Cached:          5000000 kB\n";
+    static const uint64_t mem_kb[MEM_KEYS] = {16318852, 1234567, 8000000, 400000, 5000000};
+    char buf[sizeof(meminfo)];
+
+    for (size_t n = 0; n <= strlen(stat); n++) {
+        memcpy(buf, stat, n);
+        buf[n] = '\0';
+        uint64_t f[7];
+        const char *p = buf + 4;
+        int count = n >= 4 ? scan_cpu_fields(&p, f, 7) : 0;
+        for (int i = 0; i < count; i++) {
+            ASSERT_EQ(f[i], stat_fields[i]);
+        }
+        ASSERT_EQ(count == 7, n > strlen("cpu  4705 356 584 3699176 23060 0 277"));
+    }
+
+    for (size_t n = 0; n <= strlen(meminfo); n++) {
+        memcpy(buf, meminfo, n);
+        buf[n] = '\0';
+        uint64_t kb[MEM_KEYS];
+        unsigned found = parse_meminfo(buf, kb);
+        for (int id = 0; id < MEM_KEYS; id++) {
+            if (found & MEM_BIT(id)) {
+                ASSERT_EQ(kb[id], mem_kb[id]);
+            }
+        }
+    }
+    /* Complete once MemAvailable is in, without reading further. */
+    uint64_t kb[MEM_KEYS];
+    ASSERT_EQ(parse_meminfo(meminfo, kb), MEM_NEED_AVAILABLE | MEM_BIT(MEM_FREE));
+
+    /* Numbers: blanks skipped, overflow and a missing terminator rejected. */
+    uint64_t v = 0;
+    const char *p = " \t18446744073709551615\n";
+    ASSERT_EQ(scan_u64(&p, &v), 0);
+    ASSERT_EQ(v, UINT64_MAX);
+    ASSERT_EQ(*p, '\n');
+    p = "18446744073709551616\n";
+    ASSERT_EQ(scan_u64(&p, &v), -1);
+    p = "42";
+    ASSERT_EQ(scan_u64(&p, &v), -1);
+    p = "-1\n";
+    ASSERT_EQ(scan_u64(&p, &v), -1);
+}
+
+/* Without MemAvailable, free + buffers + cached is what is available. */
+TEST(get_memory_info_fallbacks) {
+    uint64_t used = 0, total = 0;
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/meminfo",
+                  "MemTotal: 1000 kB\nMemFree: 100 kB\nActive: 5 kB\nBuffers: 50 kB\nCached: 250 kB\n", 0);
+    ASSERT_EQ(get_memory_info(&used, &total), 0);
+    ASSERT_EQ(total, 1000ULL * 1024ULL);
+    ASSERT_EQ(used, 600ULL * 1024ULL);
+
+    /* Short, colliding and colon-less lines are skipped; no MemTotal fails. */
+    memset(g_mock_files, 0, sizeof(g_mock_files));
+    metrics_close();
+    mock_set_file("/proc/meminfo", "Ab: 1 kB\nMemTotaX: 2 kB\nnonsense\nMemAvailable: 3 kB\n", 0);
+    ASSERT_EQ(get_memory_info(&used, &total), -1);
+
+    /* More available than total reads as nothing used. */
+    memset(g_mock_files, 0, sizeof(g_mock_files));
+    metrics_close();
+    mock_set_file("/proc/meminfo", "MemTotal: 10 kB\nMemAvailable: 20 kB\n", 0);
+    ASSERT_EQ(get_memory_info(&used, &total), 0);
+    ASSERT_EQ(used, 0u);
+}
+
 TEST(get_cpu_usage_paths) {
     float usage = 12.3f;
+    uint8_t pct[MAX_CORES];
+    int cores = -1;
 
     g_mock_fs_enabled = 1;
-    ASSERT_EQ(get_cpu_usage(&usage), -1);
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), -1);
 
     mock_set_file("/proc/stat", "cpu broken\n", 0);
-    ASSERT_EQ(get_cpu_usage(&usage), -1);
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), -1);
 
     memset(g_mock_files, 0, sizeof(g_mock_files));
     mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
-    ASSERT_EQ(get_cpu_usage(&usage), 0);
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
     ASSERT_FLOAT_NEAR(usage, 0.0f, 0.001f);
 
     memset(g_mock_files, 0, sizeof(g_mock_files));
     mock_set_file("/proc/stat", "cpu 200 0 200 100 0 0 0\n", 0);
-    ASSERT_EQ(get_cpu_usage(&usage), 0);
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
     ASSERT(usage > 0.0f);
 }
 
+/*
+ * Per-core usage from the cpuN lines: steal counts as busy, guest time is
+ * not counted twice, and offline, unknown and cut-off lines are skipped.
+ */
+TEST(get_cpu_usage_per_core) {
+    float usage = 0.0f;
+    uint8_t pct[MAX_CORES];
+    int cores = 0;
+    g_mock_fs_enabled = 1;
+    g_mock_nprocs = 4;
+    mock_set_file("/proc/stat",
+                  "cpu  300 0 0 300 0 0 0 0 0 0\n"
+                  "cpu0 100 0 0 100 0 0 0 0 0 0\n"
+                  "cpu1 100 0 0 100 0 0 0 0 0 0\n"
+                  "cpu3 100 0 0 100 0 0 0 0 0 0\n"
+                  "intr 1 2 3\n", 0);
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(cores, 4);
+    ASSERT_EQ(pct[0], 0);
+
+    snprintf(g_mock_files[0].content, sizeof(g_mock_files[0].content),
+             "cpu  500 0 0 450 0 0 0 100 50 0\n"
+             "cpu0 200 0 0 100 0 0 0 0 0 0\n"
+             "cpu1 150 0 0 150 0 0 0 0 50 0\n"
+             "cpux 1 2 3 4 5 6 7\n"
+             "cpu3 100 0 0 100 0 0 0 100 0 0\n"
+             "cpu9 1 1 1 1 1 1 1 1 1 1\n"
+             "cpu2 100 0 0 1");
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(cores, 4);
+    ASSERT_EQ(pct[0], 100);
+    ASSERT_EQ(pct[1], 50);
+    ASSERT_EQ(pct[2], 0);
+    ASSERT_EQ(pct[3], 100);
+    ASSERT_FLOAT_NEAR(usage, 66.67f, 0.01f);
+
+    /* Counters that went backwards read as idle rather than wrapping. */
+    snprintf(g_mock_files[0].content, sizeof(g_mock_files[0].content),
+             "cpu  600 0 0 400 0 0 0 100 50 0\ncpu0 100 0 0 100 0 0 0 0 0 0\n");
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(cores, 1);
+    ASSERT_EQ(pct[0], 0);
+    ASSERT_FLOAT_NEAR(usage, 0.0f, 0.01f);
+
+    /* Without memory for per-core state only the aggregate is read. */
+    metrics_close();
+    g_mock_malloc_fail = 1;
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(cores, 0);
+    g_mock_malloc_fail = 0;
+
+    /* Core counts are kept within 1..MAX_CORES. */
+    metrics_close();
+    g_mock_nprocs = -1;
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(g_core_slots, 1);
+    metrics_close();
+    g_mock_nprocs = 4 * MAX_CORES;
+    ASSERT_EQ(get_cpu_usage(&usage, pct, &cores), 0);
+    ASSERT_EQ(g_core_slots, MAX_CORES);
+}
+
+/* Collector files stay open; later ticks are a single pread each. */
+TEST(collect_metrics_reuses_sources) {
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/sys/class/thermal/thermal_zone0/temp", "42000\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 2000 kB\nMemAvailable: 1000 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
+    mock_set_file("/sys/class/net/eth0/statistics/rx_bytes", "100\n", 0);
+    mock_set_file("/sys/class/net/eth0/statistics/tx_bytes", "200\n", 0);
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
+    /* Two-second ticks, so everything but load and uptime is due each time. */
+    time_t times[] = {100, 102, 104, 106, 108, 110, 112};
+    mock_set_times(times, 7);
+
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 7);
+
+    /* New contents are seen without reopening. */
+    snprintf(g_mock_files[0].content, sizeof(g_mock_files[0].content), "cpu 200 0 200 100 0 0 0\n");
+    snprintf(g_mock_files[1].content, sizeof(g_mock_files[1].content), "55000\n");
+    snprintf(g_mock_files[5].content, sizeof(g_mock_files[5].content), "1100\n");
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 7);
+    ASSERT(g_sample.cpu_usage > 0.0f);
+    ASSERT_FLOAT_NEAR(g_sample.cpu_temp, 55.0f, 0.001f);
+    ASSERT_FLOAT_NEAR(g_sample.net_rx_rate, 500.0f, 0.01f);
+
+    /* A stale handle is reopened and read again within the same tick. */
+    g_mock_pread_errno = ESTALE;
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 8);
+    ASSERT_EQ(last_cpu_total, 500u);
+
+    /* Other errors fail the read; the next tick reopens the file. */
+    g_mock_pread_errno = EIO;
+    collect_metrics();
+    ASSERT_FLOAT_NEAR(g_sample.cpu_usage, 0.0f, 0.001f);
+    ASSERT_EQ(g_mock_open_calls, 8);
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 9);
+
+    /* A new interface switches the counter files. */
+    mock_set_file("/sys/class/net/eth1/statistics/rx_bytes", "5\n", 0);
+    mock_set_file("/sys/class/net/eth1/statistics/tx_bytes", "6\n", 0);
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth1");
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 11);
+    ASSERT_EQ(last_net_rx, 5u);
+    ASSERT_EQ(last_net_tx, 6u);
+
+    /* Closing makes the next tick open everything again. */
+    metrics_close();
+    collect_metrics();
+    ASSERT_EQ(g_mock_open_calls, 18);
+}
+
+/* Each metric is re-read on its own period; uptime advances in between. */
+TEST(collect_metrics_schedule) {
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/sys/class/thermal/thermal_zone0/temp", "42000\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 2000 kB\nMemAvailable: 1000 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
+    time_t times[] = {1000, 1000, 1001, 1004, 1060, 990};
+    mock_set_times(times, 6);
+
+    collect_metrics();
+    ASSERT_EQ(g_sample.uptime_secs, 100u);
+    snprintf(g_mock_files[0].content, sizeof(g_mock_files[0].content), "cpu 200 0 200 100 0 0 0\n");
+    snprintf(g_mock_files[1].content, sizeof(g_mock_files[1].content), "55000\n");
+    snprintf(g_mock_files[3].content, sizeof(g_mock_files[3].content), "500.0 0.0\n");
+    snprintf(g_mock_files[4].content, sizeof(g_mock_files[4].content), "4.0 5.0 6.0 0/0 1\n");
+
+    /* Same second: nothing is due. */
+    collect_metrics();
+    ASSERT_EQ(last_cpu_total, 300u);
+
+    /* One second on: CPU only, uptime counts along. */
+    collect_metrics();
+    ASSERT_EQ(last_cpu_total, 500u);
+    ASSERT_FLOAT_NEAR(g_sample.cpu_temp, 42.0f, 0.001f);
+    ASSERT_EQ(g_sample.uptime_secs, 101u);
+
+    /* Four seconds on: temperature is due, the load average not yet. */
+    collect_metrics();
+    ASSERT_FLOAT_NEAR(g_sample.cpu_temp, 55.0f, 0.001f);
+    ASSERT_FLOAT_NEAR(g_sample.load_1, 1.0f, 0.001f);
+    ASSERT_EQ(g_sample.uptime_secs, 104u);
+
+    /* A minute on: load and uptime are read again. */
+    collect_metrics();
+    ASSERT_FLOAT_NEAR(g_sample.load_1, 4.0f, 0.001f);
+    ASSERT_EQ(g_sample.uptime_secs, 500u);
+
+    /* The clock stepping back runs everything rather than stalling. */
+    snprintf(g_mock_files[3].content, sizeof(g_mock_files[3].content), "600.0 0.0\n");
+    collect_metrics();
+    ASSERT_EQ(g_sample.uptime_secs, 600u);
+}
+
+#define SNAPSHOT_ROUNDS 20000
+
+/* Publishes samples whose fields all carry the round number. */
+static void *snapshot_writer(void *arg) {
+    (void)arg;
+    for (int i = 1; i <= SNAPSHOT_ROUNDS; i++) {
+        g_sample.cpu_usage = (float)i;
+        g_sample.mem_pct = (float)i;
+        g_sample.uptime_secs = (uint64_t)i;
+        snprintf(g_sample.hostname, sizeof(g_sample.hostname), "h%d", i);
+        g_pve_sample.running_vms = i;
+        g_pve_sample.storage[7].used_bytes = (uint64_t)i;
+        metrics_publish();
+    }
+    return NULL;
+}
+
+/* The render side never sees a half-written or older snapshot. */
+TEST(metrics_snapshots_are_consistent) {
+    ASSERT_EQ(metrics_update(), 0);
+
+    pthread_t writer;
+    ASSERT_EQ(libc_pthread_create(&writer, NULL, snapshot_writer, NULL), 0);
+    uint64_t seen = 0;
+    char host[16];
+    while (seen < SNAPSHOT_ROUNDS) {
+        if (!metrics_update()) {
+            continue;
+        }
+        uint64_t i = g_metrics.uptime_secs;
+        ASSERT(i > seen);
+        ASSERT_FLOAT_NEAR(g_metrics.cpu_usage, (float)i, 0.001f);
+        ASSERT_FLOAT_NEAR(g_metrics.mem_pct, (float)i, 0.001f);
+        snprintf(host, sizeof(host), "h%d", (int)i);
+        ASSERT_STREQ(g_metrics.hostname, host);
+        ASSERT_EQ(g_pve_metrics.running_vms, (int)i);
+        ASSERT_EQ(g_pve_metrics.storage[7].used_bytes, i);
+        seen = i;
+    }
+    pthread_join(writer, NULL);
+    ASSERT_EQ(metrics_update(), 0);
+}
+
+/* The collector thread reads the files and publishes what it found. */
+TEST(collector_thread_publishes) {
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/meminfo", "MemTotal: 2000 kB\nMemAvailable: 1000 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    g_mock_collector_thread = 1;
+
+    ASSERT_EQ(collector_start(), 0);
+    for (int tries = 0; tries < 500 && g_metrics.mem_total == 0; tries++) {
+        struct timespec ts = {0, 10000000};
+        nanosleep(&ts, NULL);
+        metrics_update();
+    }
+    collector_stop();
+    collector_stop();
+    ASSERT_EQ(g_metrics.mem_total, 2000ULL * 1024ULL);
+    ASSERT(g_metrics.uptime_secs >= 100u);
+
+    g_mock_pthread_create_fail = 1;
+    ASSERT_EQ(collector_start(), -1);
+}
+
 TEST(get_memory_temp_host_load_uptime_paths) {
     uint64_t used = 0, total = 0;
     float temp = 0.0f;
@@ -933,13 +1986,13 @@ TEST(get_memory_temp_host_load_uptime_paths) {
 TEST(detect_network_interface_paths) {
     snprintf(g_cli_iface, sizeof(g_cli_iface), "cli0");
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "cli0");
+    ASSERT_STREQ(g_sample.net_iface, "cli0");
 
     g_cli_iface[0] = '\0';
     g_use_mock_net_dir = 1;
     snprintf(g_mock_net_dir, sizeof(g_mock_net_dir), "/tmp/does-not-exist-homelab-screen");
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "eth0");
+    ASSERT_STREQ(g_sample.net_iface, "eth0");
     g_use_mock_net_dir = 0;
     g_mock_net_dir[0] = '\0';
 
@@ -949,7 +2002,7 @@ TEST(detect_network_interface_paths) {
     mock_set_file("/sys/class/net/ethA/carrier", "0\n", 0);
     mock_set_file("/sys/class/net/ethB/carrier", "1\n", 0);
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "ethB");
+    ASSERT_STREQ(g_sample.net_iface, "ethB");
 
     cleanup_mock_net_dir();
     reset_test_state();
@@ -959,7 +2012,7 @@ TEST(detect_network_interface_paths) {
     g_mock_fs_enabled = 1;
     mock_set_file("/sys/class/net/ethX/carrier", "0\n", 0);
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "ethX");
+    ASSERT_STREQ(g_sample.net_iface, "ethX");
 
     cleanup_mock_net_dir();
     reset_test_state();
@@ -968,7 +2021,7 @@ TEST(detect_network_interface_paths) {
     setup_mock_net_dir(entries3, 1);
     g_mock_fs_enabled = 1;
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "eth0");
+    ASSERT_STREQ(g_sample.net_iface, "eth0");
 
     cleanup_mock_net_dir();
     reset_test_state();
@@ -980,12 +2033,12 @@ TEST(detect_network_interface_paths) {
     g_mock_snprintf_fail_once = 1;
     snprintf(g_mock_snprintf_fail_substr, sizeof(g_mock_snprintf_fail_substr), "/sys/class/net/");
     detect_network_interface();
-    ASSERT_STREQ(g_metrics.net_iface, "eth0");
+    ASSERT_STREQ(g_sample.net_iface, "eth0");
 }
 
 TEST(get_network_rates_and_collect_metrics) {
     g_mock_fs_enabled = 1;
-    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
     mock_set_file("/sys/class/net/eth0/statistics/rx_bytes", "2000\n", 0);
     mock_set_file("/sys/class/net/eth0/statistics/tx_bytes", "3000\n", 0);
     last_net_rx = 1000;
@@ -993,20 +2046,20 @@ TEST(get_network_rates_and_collect_metrics) {
     last_net_time = 10;
     time_t times[] = {12};
     mock_set_times(times, 1);
-    get_network_rates();
-    ASSERT_FLOAT_NEAR(g_metrics.net_rx_rate, 500.0f, 0.01f);
-    ASSERT_FLOAT_NEAR(g_metrics.net_tx_rate, 1000.0f, 0.01f);
+    get_network_rates(test_time(NULL));
+    ASSERT_FLOAT_NEAR(g_sample.net_rx_rate, 500.0f, 0.01f);
+    ASSERT_FLOAT_NEAR(g_sample.net_tx_rate, 1000.0f, 0.01f);
 
     memset(g_mock_files, 0, sizeof(g_mock_files));
-    g_metrics.net_iface[0] = '\0';
-    float prev_rx_rate = g_metrics.net_rx_rate;
-    float prev_tx_rate = g_metrics.net_tx_rate;
+    g_sample.net_iface[0] = '\0';
+    float prev_rx_rate = g_sample.net_rx_rate;
+    float prev_tx_rate = g_sample.net_tx_rate;
     uint64_t prev_last_rx = last_net_rx;
     uint64_t prev_last_tx = last_net_tx;
     time_t prev_last_time = last_net_time;
-    get_network_rates();
-    ASSERT_FLOAT_NEAR(g_metrics.net_rx_rate, prev_rx_rate, 0.001f);
-    ASSERT_FLOAT_NEAR(g_metrics.net_tx_rate, prev_tx_rate, 0.001f);
+    get_network_rates(test_time(NULL));
+    ASSERT_FLOAT_NEAR(g_sample.net_rx_rate, prev_rx_rate, 0.001f);
+    ASSERT_FLOAT_NEAR(g_sample.net_tx_rate, prev_tx_rate, 0.001f);
     ASSERT_EQ(last_net_rx, prev_last_rx);
     ASSERT_EQ(last_net_tx, prev_last_tx);
     ASSERT_EQ(last_net_time, prev_last_time);
@@ -1017,13 +2070,13 @@ TEST(get_network_rates_and_collect_metrics) {
     mock_set_file("/proc/meminfo", "MemTotal: 1000 kB\nMemAvailable: 1000 kB\n", 0);
     mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
     mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
-    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
     mock_set_file("/sys/class/net/eth0/statistics/rx_bytes", "x\n", 0);
     mock_set_file("/sys/class/net/eth0/statistics/tx_bytes", "y\n", 0);
     time_t times2[] = {100};
     mock_set_times(times2, 1);
     collect_metrics();
-    ASSERT_FLOAT_NEAR(g_metrics.mem_pct, 0.0f, 0.001f);
+    ASSERT_FLOAT_NEAR(g_sample.mem_pct, 0.0f, 0.001f);
 
     memset(g_mock_files, 0, sizeof(g_mock_files));
     mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
@@ -1031,13 +2084,13 @@ TEST(get_network_rates_and_collect_metrics) {
     mock_set_file("/proc/meminfo", "MemTotal: 2000 kB\nMemAvailable: 1000 kB\n", 0);
     mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
     mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
-    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
     mock_set_file("/sys/class/net/eth0/statistics/rx_bytes", "100\n", 0);
     mock_set_file("/sys/class/net/eth0/statistics/tx_bytes", "200\n", 0);
     time_t times3[] = {200};
     mock_set_times(times3, 1);
     collect_metrics();
-    ASSERT(g_metrics.mem_pct > 0.0f);
+    ASSERT(g_sample.mem_pct > 0.0f);
 
     reset_test_state();
     g_mock_fs_enabled = 1;
@@ -1045,13 +2098,13 @@ TEST(get_network_rates_and_collect_metrics) {
     mock_set_file("/sys/class/thermal/thermal_zone0/temp", "42000\n", 0);
     mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
     mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
-    snprintf(g_metrics.net_iface, sizeof(g_metrics.net_iface), "eth0");
+    snprintf(g_sample.net_iface, sizeof(g_sample.net_iface), "eth0");
     mock_set_file("/sys/class/net/eth0/statistics/rx_bytes", "100\n", 0);
     mock_set_file("/sys/class/net/eth0/statistics/tx_bytes", "200\n", 0);
     time_t times4[] = {300};
     mock_set_times(times4, 1);
     collect_metrics();
-    ASSERT_FLOAT_NEAR(g_metrics.mem_pct, 0.0f, 0.001f);
+    ASSERT_FLOAT_NEAR(g_sample.mem_pct, 0.0f, 0.001f);
 }
 
 /* ===== Proxmox ===== */
@@ -1110,13 +2163,13 @@ TEST(check_pve_available_paths) {
     snprintf(g_mock_hostname_value, sizeof(g_mock_hostname_value), "node-x");
 
     check_pve_available();
-    ASSERT_EQ(g_pve_metrics.pve_available, 0);
-    ASSERT_STREQ(g_pve_metrics.node_name, "node-x");
+    ASSERT_EQ(g_pve_sample.pve_available, 0);
+    ASSERT_STREQ(g_pve_sample.node_name, "node-x");
 
     memset(g_mock_access, 0, sizeof(g_mock_access));
     mock_set_access("/usr/bin/pvesh", 0);
     check_pve_available();
-    ASSERT_EQ(g_pve_metrics.pve_available, 1);
+    ASSERT_EQ(g_pve_sample.pve_available, 1);
 }
 
 TEST(get_pve_vms_cts_and_version) {
@@ -1124,19 +2177,19 @@ TEST(get_pve_vms_cts_and_version) {
 
     mock_add_cmd("qm list 2>/dev/null", "VMID NAME STATUS\n100 a running\n101 b stopped\n", 0, 0);
     get_pve_vms();
-    ASSERT_EQ(g_pve_metrics.total_vms, 2);
-    ASSERT_EQ(g_pve_metrics.running_vms, 1);
+    ASSERT_EQ(g_pve_sample.total_vms, 2);
+    ASSERT_EQ(g_pve_sample.running_vms, 1);
 
     memset(g_mock_cmds, 0, sizeof(g_mock_cmds));
     mock_add_cmd("pct list 2>/dev/null", "VMID NAME STATUS\n200 c running\n\n", 0, 0);
     get_pve_cts();
-    ASSERT_EQ(g_pve_metrics.total_cts, 1);
-    ASSERT_EQ(g_pve_metrics.running_cts, 1);
+    ASSERT_EQ(g_pve_sample.total_cts, 1);
+    ASSERT_EQ(g_pve_sample.running_cts, 1);
 
     memset(g_mock_cmds, 0, sizeof(g_mock_cmds));
     mock_add_cmd("pveversion 2>/dev/null", "pve-manager/8.2\n", 0, 0);
     get_pve_version();
-    ASSERT_STREQ(g_pve_metrics.pve_version, "pve-manager/8.2");
+    ASSERT_STREQ(g_pve_sample.pve_version, "pve-manager/8.2");
 
     memset(g_mock_cmds, 0, sizeof(g_mock_cmds));
     memset(g_mock_files, 0, sizeof(g_mock_files));
@@ -1144,12 +2197,12 @@ TEST(get_pve_vms_cts_and_version) {
     mock_add_cmd("pveversion 2>/dev/null", "", 0, 0);
     mock_set_file("/etc/pve/.version", "8.3.0\n", 0);
     get_pve_version();
-    ASSERT_STREQ(g_pve_metrics.pve_version, "8.3.0");
+    ASSERT_STREQ(g_pve_sample.pve_version, "8.3.0");
 }
 
 TEST(get_pve_storage_json_and_fallback) {
     g_mock_proc_enabled = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node?bad");
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node?bad");
 
     mock_add_cmd("pvesh get /nodes/", ""
         "[{\"storage\":\"local\",\"used\":100,\"total\":200},"
@@ -1159,50 +2212,50 @@ TEST(get_pve_storage_json_and_fallback) {
         "{\"storage\":\"broken\",\"used\":1]",
         0, 1);
     get_pve_storage();
-    ASSERT(g_pve_metrics.storage_count >= 1);
-    ASSERT_STREQ(g_pve_metrics.storage[0].name, "local");
-    ASSERT(g_pve_metrics.storage[1].used_pct == 0.0f);
+    ASSERT(g_pve_sample.storage_count >= 1);
+    ASSERT_STREQ(g_pve_sample.storage[0].name, "local");
+    ASSERT(g_pve_sample.storage[1].used_pct == 0.0f);
 
     reset_test_state();
     g_mock_proc_enabled = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node1");
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node1");
     mock_add_cmd("pvesh get /nodes/node1/storage --output-format json 2>/dev/null", "", 1, 0);
     mock_add_cmd("df -B1 /var/lib/vz 2>/dev/null", "Filesystem 1B-blocks Used Available Use% Mounted\n/dev/sda 1000 500 500 50% /var/lib/vz\n", 0, 0);
     mock_add_cmd("df -B1 /var/lib/pve/local-btrfs 2>/dev/null", "Filesystem 1B-blocks Used Available Use% Mounted\n/dev/sdb 0 0 0 0% /var/lib/pve/local-btrfs\n", 0, 0);
     get_pve_storage();
-    ASSERT(g_pve_metrics.storage_count >= 1);
+    ASSERT(g_pve_sample.storage_count >= 1);
 
     reset_test_state();
     g_mock_proc_enabled = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node1");
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node1");
     mock_add_cmd("pvesh get /nodes/node1/storage --output-format json 2>/dev/null", "\"storage\":\"x\"}", 0, 0);
     get_pve_storage();
-    ASSERT_EQ(g_pve_metrics.storage_count, 0);
+    ASSERT_EQ(g_pve_sample.storage_count, 0);
 
     reset_test_state();
     g_mock_proc_enabled = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node1");
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node1");
     mock_add_cmd("pvesh get /nodes/node1/storage --output-format json 2>/dev/null", "[{\"storage\"}]", 0, 0);
     get_pve_storage();
-    ASSERT_EQ(g_pve_metrics.storage_count, 0);
+    ASSERT_EQ(g_pve_sample.storage_count, 0);
 
     reset_test_state();
     g_mock_proc_enabled = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node1");
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node1");
     char huge[20000];
     memset(huge, 'a', sizeof(huge) - 1);
     huge[sizeof(huge) - 1] = '\0';
     mock_add_cmd("pvesh get /nodes/node1/storage --output-format json 2>/dev/null", huge, 0, 0);
     get_pve_storage();
-    ASSERT_EQ(g_pve_metrics.storage_count, 0);
+    ASSERT_EQ(g_pve_sample.storage_count, 0);
 }
 
 TEST(collect_proxmox_metrics_paths) {
-    g_pve_metrics.pve_available = 0;
+    g_pve_sample.pve_available = 0;
     collect_proxmox_metrics();
-    ASSERT_EQ(g_pve_metrics.total_vms, 0);
+    ASSERT_EQ(g_pve_sample.total_vms, 0);
 
-    g_pve_metrics.pve_available = 1;
+    g_pve_sample.pve_available = 1;
     last_pve_collect = 100;
     g_mock_time_enabled = 1;
     g_mock_times[0] = 105;
@@ -1211,8 +2264,8 @@ TEST(collect_proxmox_metrics_paths) {
     ASSERT_EQ(last_pve_collect, 100);
 
     reset_test_state();
-    g_pve_metrics.pve_available = 1;
-    snprintf(g_pve_metrics.node_name, sizeof(g_pve_metrics.node_name), "node1");
+    g_pve_sample.pve_available = 1;
+    snprintf(g_pve_sample.node_name, sizeof(g_pve_sample.node_name), "node1");
     g_mock_proc_enabled = 1;
     mock_add_cmd("qm list 2>/dev/null", "VMID NAME STATUS\n100 a running\n", 0, 0);
     mock_add_cmd("pct list 2>/dev/null", "VMID NAME STATUS\n200 c stopped\n", 0, 0);
@@ -1221,9 +2274,9 @@ TEST(collect_proxmox_metrics_paths) {
     time_t times[] = {200};
     mock_set_times(times, 1);
     collect_proxmox_metrics();
-    ASSERT_EQ(g_pve_metrics.total_vms, 1);
-    ASSERT_EQ(g_pve_metrics.total_cts, 1);
-    ASSERT_EQ(g_pve_metrics.storage_count, 1);
+    ASSERT_EQ(g_pve_sample.total_vms, 1);
+    ASSERT_EQ(g_pve_sample.total_cts, 1);
+    ASSERT_EQ(g_pve_sample.storage_count, 1);
 }
 
 /* ===== USB ===== */
@@ -1265,6 +2318,17 @@ TEST(usb_init_error_paths) {
     reset_test_state();
     mock_libusb_claim_interface_rc = -5;
     ASSERT_EQ(usb_init(), -1);
+
+    reset_test_state();
+    mock_libusb_alloc_transfer_fail = 1;
+    ASSERT_EQ(usb_init(), -1);
+    ASSERT_EQ(mock_libusb_released_iface, 0);
+
+    reset_test_state();
+    g_mock_pthread_create_fail = 1;
+    ASSERT_EQ(usb_init(), -1);
+    ASSERT_EQ(g_usb_thread_running, 0);
+    ASSERT(g_panels[0].slots[0].xfer == NULL);
 }
 
 TEST(usb_init_success_and_cleanup) {
@@ -1272,63 +2336,344 @@ TEST(usb_init_success_and_cleanup) {
     mock_libusb_interface_number = 3;
     mock_libusb_endpoint_addr = 0x04;
     ASSERT_EQ(usb_init(), 0);
-    ASSERT_EQ(g_usb_iface, 3);
-    ASSERT_EQ(g_ep_out, 0x04);
+    ASSERT_EQ(g_panels[0].iface, 3);
+    ASSERT_EQ(g_panels[0].ep_out, 0x04);
     ASSERT_EQ(mock_libusb_claimed_iface, 3);
+    ASSERT_EQ(g_usb_thread_running, 1);
 
     usb_cleanup();
-    ASSERT_EQ(g_usb_iface, -1);
-    ASSERT_EQ(g_ep_out, 0);
+    ASSERT_EQ(g_panels[0].iface, -1);
+    ASSERT_EQ(g_panels[0].ep_out, 0);
     ASSERT_EQ(mock_libusb_released_iface, 3);
+    ASSERT_EQ(g_usb_thread_running, 0);
+
+    /* A handle without a claimed interface is closed without release. */
+    g_panels[0].handle = &mock_libusb_handles[0];
+    g_panels[0].iface = -1;
+    mock_libusb_released_iface = -1;
+    usb_close_device(&g_panels[0]);
+    ASSERT(g_panels[0].handle == NULL);
+    ASSERT_EQ(mock_libusb_released_iface, -1);
+}
 
-    dev_handle = (libusb_device_handle *)0x1;
-    g_usb_iface = -1;
+TEST(send_frame_paths) {
+    ASSERT_EQ(usb_init(), 0);
+    clear_fb();
+    framebuffer[0] = htole16(0x1234);
+    framebuffer[LCD_W * LCD_H - 1] = htole16(0xABCD);
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    ASSERT_EQ(mock_libusb_captured, (size_t)TRANSFER_SIZE);
+    ASSERT_EQ(mock_libusb_capture[0], 0xDA);
+    ASSERT_EQ(mock_libusb_capture[PACKET_SIZE], 0x34);
+    ASSERT_EQ(mock_libusb_capture[PACKET_SIZE + 1], 0x12);
+    ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE - 2], 0xCD);
+    ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE - 1], 0xAB);
+
+    /* Frames alternate between slots and overlap with the caller. */
+    reset_test_state();
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    framebuffer[0] = 1;
+    ASSERT_EQ(send_frame(), 0);
+    framebuffer[0] = 2;
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT(framebuffer == g_panels[0].slots[1].buf + PACKET_SIZE / 2);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(mock_libusb_submit_calls, 3);
+    ASSERT_EQ(g_panels[0].next_slot, 1);
+    usb_cleanup();
+
+    reset_test_state();
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_submit_rc = LIBUSB_ERROR_NO_DEVICE;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    ASSERT_EQ(g_panels[0].slots[0].busy, 0);
+    usb_cleanup();
+
+    reset_test_state();
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_transfer_fail_after = 0;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_NO_DEVICE;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
     usb_cleanup();
-    ASSERT_EQ(g_usb_iface, -1);
+
+    ASSERT_STREQ(transfer_status_name(LIBUSB_TRANSFER_STALL), "STALL");
+    ASSERT_STREQ(transfer_status_name((enum libusb_transfer_status)42), "UNKNOWN");
 }
 
-TEST(send_frame_paths) {
-    static libusb_device_handle fake_handle;
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
+TEST(send_frame_packet_mode_paths) {
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, 301);
+    ASSERT_EQ(mock_libusb_captured, (size_t)TRANSFER_SIZE);
+
+    reset_test_state();
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_submit_rc = -1;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    usb_cleanup();
 
+    reset_test_state();
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_short_write = 1;
     ASSERT_EQ(send_frame(), 0);
-    ASSERT_EQ(mock_libusb_bulk_calls, 301);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    usb_cleanup();
 
     reset_test_state();
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
-    mock_libusb_bulk_transfer_rc = -1;
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_short_write_after = 1;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
     ASSERT_EQ(send_frame(), -1);
-    ASSERT_EQ(mock_libusb_bulk_calls, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+    usb_cleanup();
 
     reset_test_state();
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
-    mock_libusb_bulk_short_write = 1;
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_submit_fail_after = 1;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
     ASSERT_EQ(send_frame(), -1);
-    ASSERT_EQ(mock_libusb_bulk_calls, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+    usb_cleanup();
 
     reset_test_state();
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
-    mock_libusb_bulk_transfer_rc = -2;
+    g_chunk_size = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    mock_libusb_transfer_fail_after = 3;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_TIMED_OUT;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
     ASSERT_EQ(send_frame(), -1);
-    ASSERT_EQ(mock_libusb_bulk_calls, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 4);
+    usb_cleanup();
+}
 
+TEST(send_frame_chunking_and_fallback) {
+    g_chunk_size = 16 * PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, (TRANSFER_SIZE + 16 * PACKET_SIZE - 1) / (16 * PACKET_SIZE));
+    ASSERT_EQ(mock_libusb_captured, (size_t)TRANSFER_SIZE);
+
+    /* Back-to-back chunked frames go out whole, one after the other. */
+    static uint16_t first[LCD_W * LCD_H];
+    for (int fallback = 0; fallback < 2; fallback++) {
+        reset_test_state();
+        g_chunk_size = fallback ? TRANSFER_SIZE : PACKET_SIZE;
+        mock_libusb_reject_len_above = fallback ? PACKET_SIZE : 0;
+        ASSERT_EQ(usb_init(), 0);
+        for (int i = 0; i < LCD_W * LCD_H; i++) framebuffer[i] = (uint16_t)i;
+        memcpy(first, framebuffer, FRAME_SIZE);
+        ASSERT_EQ(send_frame(), 0);
+        for (int i = 0; i < LCD_W * LCD_H; i++) framebuffer[i] = (uint16_t)~i;
+        ASSERT_EQ(send_frame(), 0);
+        wait_transport_idle(&g_panels[0]);
+        ASSERT_EQ(atomic_load(&g_panels[0].chunk), PACKET_SIZE);
+        ASSERT_EQ(mock_libusb_captured, (size_t)2 * TRANSFER_SIZE);
+        ASSERT_EQ(mock_libusb_capture[0], 0xDA);
+        ASSERT(memcmp(mock_libusb_capture + PACKET_SIZE, first, FRAME_SIZE) == 0);
+        ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE], 0xDA);
+        ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE + PACKET_SIZE], 0xFF);
+        usb_cleanup();
+    }
+
+    /* Oversized chunk requests are clamped to a single submission. */
     reset_test_state();
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
-    mock_libusb_bulk_short_write_after = 1;
+    g_chunk_size = 2 * TRANSFER_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+
+    /* Submission rejected: retry the frame in packet mode. */
+    reset_test_state();
+    mock_libusb_reject_len_above = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), PACKET_SIZE);
+    ASSERT_EQ(mock_libusb_submit_calls, 1 + 301);
+    ASSERT_EQ(mock_libusb_captured, (size_t)TRANSFER_SIZE);
+    framebuffer[0]++;
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, 1 + 2 * 301);
+
+    /* Device stalls a large header: drop the frame, clear the halt, continue in packets. */
+    reset_test_state();
+    mock_libusb_stall_len_above = PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), PACKET_SIZE);
+    ASSERT_EQ(mock_libusb_clear_halt_calls, 0);
+    framebuffer[0]++;
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_clear_halt_calls, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1 + 301);
+    ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE], 0xDA);
+
+    /* A header that times out before any byte went out is retried in packets. */
+    reset_test_state();
+    mock_libusb_fail_len_above = PACKET_SIZE;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_TIMED_OUT;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), PACKET_SIZE);
+    ASSERT_EQ(g_panels[0].stats.retries, 1ULL);
+    ASSERT_EQ(g_panels[0].stats.completed, 1ULL);
+    ASSERT_EQ(mock_libusb_submit_calls, 1 + 301);
+    usb_cleanup();
+
+    /* Already in packets, or the retry cannot be submitted: fail the frame. */
+    reset_test_state();
+    g_chunk_size = PACKET_SIZE;
+    mock_libusb_transfer_fail_after = 0;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    usb_cleanup();
+
+    reset_test_state();
+    mock_libusb_fail_len_above = PACKET_SIZE;
+    mock_libusb_submit_fail_after = 1;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(g_panels[0].stats.retries, 1ULL);
     ASSERT_EQ(send_frame(), -1);
-    ASSERT_EQ(mock_libusb_bulk_calls, 2);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+    usb_cleanup();
 
+    /* Bus errors on submit are not a size problem: no fallback. */
     reset_test_state();
-    dev_handle = &fake_handle;
-    g_ep_out = 0x02;
-    mock_libusb_bulk_fail_after = 1;
+    mock_libusb_submit_rc = -1;
+    ASSERT_EQ(usb_init(), 0);
     ASSERT_EQ(send_frame(), -1);
-    ASSERT_EQ(mock_libusb_bulk_calls, 2);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    ASSERT(atomic_load(&g_panels[0].chunk) > PACKET_SIZE);
+    usb_cleanup();
+}
+
+TEST(send_frame_stall_mid_frame) {
+    /* Two chunks delivered, the third stalls: no restart from the header. */
+    g_chunk_size = 16 * PACKET_SIZE;
+    mock_libusb_transfer_fail_after = 2;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_STALL;
+    ASSERT_EQ(usb_init(), 0);
+    framebuffer[0] = 0;
+    const UsbStats *st = &g_panels[0].stats;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(mock_libusb_submit_calls, 3);
+    ASSERT_EQ(st->failed, 1ULL);
+    ASSERT_EQ(st->retries, 0ULL);
+    ASSERT_EQ(st->bytes, (uint64_t)(2 * 16 * PACKET_SIZE));
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), 16 * PACKET_SIZE);
+
+    /* The next frame clears the halt and resyncs from its header on the same handle. */
+    mock_libusb_transfer_fail_after = -1;
+    framebuffer[0] = 1;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(mock_libusb_clear_halt_calls, 1);
+    ASSERT(g_panels[0].handle != NULL);
+    ASSERT_EQ(st->completed, 1ULL);
+    ASSERT_EQ(mock_libusb_capture[3 * 16 * PACKET_SIZE], 0xDA);
+
+    /* Without clear_halt the endpoint stays stuck: give up on the device. */
+    mock_libusb_transfer_fail_after = 0;
+    framebuffer[0] = 2;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    mock_libusb_transfer_fail_after = -1;
+    mock_libusb_clear_halt_rc = LIBUSB_ERROR_IO;
+    mock_libusb_open_ok = 0;
+    framebuffer[0] = 3;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_clear_halt_calls, 2);
+    ASSERT(g_panels[0].handle == NULL);
+    usb_cleanup();
+}
+
+TEST(send_frame_skips_unchanged_frames) {
+    ASSERT_EQ(usb_init(), 0);
+    clear_fb();
+    ASSERT_EQ(send_frame(), 0);
+    clear_fb(); /* back buffer flipped, redraw the same frame */
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_sent, 1ULL);
+    ASSERT_EQ(g_panels[0].frames_skipped, 2ULL);
+
+    framebuffer[LCD_W * LCD_H / 2] = 0x0001;
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_sent, 2ULL);
+
+    /* Keep-alive resend once the interval has passed. */
+    g_keepalive = 1;
+    g_panels[0].last_sent.tv_sec -= 2;
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_sent, 3ULL);
+    ASSERT_EQ(g_panels[0].frames_skipped, 2ULL);
+
+    /* A frame vouched for as unchanged reuses the last hash instead of reading the buffer. */
+    framebuffer[0] ^= 1;
+    ASSERT_EQ(send_unchanged_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_skipped, 3ULL);
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_sent, 4ULL);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_submit_calls, 4);
+
+    /* Without a queued frame to compare with, it is hashed after all. */
+    reset_test_state();
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(send_unchanged_frame(), 0);
+    ASSERT_EQ(g_panels[0].frames_sent, 1ULL);
+    usb_cleanup();
+}
+
+TEST(pixel_hash64_properties) {
+    static uint16_t a[LCD_W * LCD_H];
+    static uint16_t b[LCD_W * LCD_H];
+    memset(a, 0, sizeof(a));
+    memset(b, 0, sizeof(b));
+    ASSERT_EQ(pixel_hash64(a, sizeof(a)), pixel_hash64(b, sizeof(b)));
+    ASSERT_NE(pixel_hash64(a, sizeof(a)), pixel_hash64(a, sizeof(a) - 32));
+
+    b[LCD_W * LCD_H - 1] = 1;
+    ASSERT_NE(pixel_hash64(a, sizeof(a)), pixel_hash64(b, sizeof(b)));
+
+    /* Swapping two 16-pixel blocks in the same lane must change the hash. */
+    memset(b, 0, sizeof(b));
+    for (int i = 0; i < 16; i++) {
+        a[i] = (uint16_t)(0x1000 + i);
+        b[16 + i] = (uint16_t)(0x1000 + i);
+    }
+    ASSERT_NE(pixel_hash64(a, sizeof(a)), pixel_hash64(b, sizeof(b)));
 }
 
 TEST(mock_libusb_direct_paths) {
@@ -1348,10 +2693,283 @@ TEST(mock_libusb_direct_paths) {
 
 TEST(signal_handler_sets_running_zero) {
     g_running = 1;
+    signal_handler(SIGUSR1);
+    ASSERT_EQ(g_running, 1);
+    ASSERT_EQ(g_stats_requested, 1);
     signal_handler(SIGTERM);
     ASSERT_EQ(g_running, 0);
 }
 
+TEST(usb_reconnects_on_hotplug_arrival) {
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(g_panels[0].hotplug_registered, 1);
+    clear_fb();
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+
+    /* Unplugged: the next submit fails and frames are dropped. */
+    mock_libusb_unplug();
+    framebuffer[0]++;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT(g_panels[0].handle == NULL);
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+
+    /* Replug: the arrival callback lets the very next frame through. */
+    mock_libusb_replug();
+    while (!atomic_load(&g_panels[0].arrived)) {
+        struct timespec ts = {0, 1000000};
+        libc_nanosleep(&ts, NULL);
+    }
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT(g_panels[0].handle != NULL);
+    ASSERT_EQ(mock_libusb_submit_calls, 3);
+    usb_cleanup();
+    ASSERT(mock_libusb_hotplug_cb[0] == NULL);
+}
+
+TEST(usb_reconnect_backoff_without_hotplug) {
+    mock_libusb_hotplug_supported = 0;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(g_panels[0].hotplug_registered, 0);
+
+    /* Device vanishes mid-transfer. */
+    mock_libusb_transfer_fail_after = 0;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_NO_DEVICE;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    mock_libusb_open_ok = 0;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT(g_panels[0].handle == NULL);
+    ASSERT_EQ(g_panels[0].retry_ms, (long)USB_RETRY_MIN_MS);
+
+    /* Each failed attempt doubles the delay up to the cap. */
+    g_panels[0].last_attempt.tv_sec -= 10;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(g_panels[0].retry_ms, 2L * USB_RETRY_MIN_MS);
+    g_panels[0].retry_ms = USB_RETRY_MAX_MS;
+    g_panels[0].last_attempt.tv_sec -= 10;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(g_panels[0].retry_ms, (long)USB_RETRY_MAX_MS);
+
+    /* Back again: the chunk size is renegotiated and the frame goes out. */
+    mock_libusb_open_ok = 1;
+    mock_libusb_transfer_fail_after = -1;
+    atomic_store(&g_panels[0].chunk, PACKET_SIZE);
+    ASSERT_EQ(send_frame(), -1);
+    g_panels[0].last_attempt.tv_sec -= 10;
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), TRANSFER_SIZE);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+    usb_cleanup();
+
+    reset_test_state();
+    mock_libusb_hotplug_register_rc = LIBUSB_ERROR_NOT_SUPPORTED;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(g_panels[0].hotplug_registered, 0);
+    usb_cleanup();
+}
+
+TEST(usb_multiple_panels) {
+    /* Two identical coolers plus a panel pinned by bus:addr. */
+    mock_libusb_add_device(0x0416, 0x5302, 1, 3);
+    mock_libusb_add_device(0x87AD, 0x70DB, 2, 5);
+    mock_libusb_add_device(0x87AD, 0x70DB, 2, 9);
+    g_panel_cfg[0] = (PanelConfig){0x0416, 0x5302, -1, -1};
+    g_panel_cfg[1] = (PanelConfig){0x0416, 0x5302, -1, -1};
+    g_panel_cfg[2] = (PanelConfig){0x87AD, 0x70DB, 2, 9};
+    g_num_panels = 3;
+
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(usb_panel_count(), 3);
+    ASSERT_EQ(g_panels[0].addr, 2);
+    ASSERT_EQ(g_panels[1].addr, 3);
+    ASSERT_EQ(g_panels[2].addr, 9);
+
+    for (int i = 0; i < 3; i++) {
+        usb_select_panel(i);
+        ASSERT(framebuffer == g_panels[i].slots[0].buf + PACKET_SIZE / 2);
+        clear_fb();
+        framebuffer[0] = htole16((uint16_t)(0x100 + i));
+        ASSERT_EQ(send_frame(), 0);
+        ASSERT(framebuffer == g_panels[i].slots[1].buf + PACKET_SIZE / 2);
+    }
+    for (int i = 0; i < 3; i++) {
+        wait_transport_idle(&g_panels[i]);
+        ASSERT_EQ(g_panels[i].frames_sent, 1ULL);
+    }
+    ASSERT_EQ(mock_libusb_submit_calls, 3);
+    ASSERT_EQ(mock_libusb_capture[TRANSFER_SIZE + PACKET_SIZE], 0x01);
+    ASSERT_EQ(mock_libusb_capture[2 * TRANSFER_SIZE + PACKET_SIZE], 0x02);
+    usb_cleanup();
+    ASSERT_EQ(usb_panel_count(), 0);
+
+    /* A panel missing at startup is opened once it shows up. */
+    reset_test_state();
+    g_panel_cfg[0] = (PanelConfig){0x0416, 0x5302, -1, -1};
+    g_panel_cfg[1] = (PanelConfig){0x0416, 0x5302, -1, -1};
+    g_num_panels = 2;
+    mock_libusb_hotplug_supported = 0;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT(g_panels[1].handle == NULL);
+    usb_select_panel(1);
+    ASSERT_EQ(send_frame(), -1);
+    mock_libusb_add_device(0x0416, 0x5302, 1, 3);
+    g_panels[1].last_attempt.tv_sec -= 10;
+    ASSERT_EQ(send_frame(), 0);
+    ASSERT_EQ(g_panels[1].addr, 3);
+    usb_cleanup();
+
+    /* Enumeration failures look like an absent device. */
+    reset_test_state();
+    mock_libusb_device_list_rc = LIBUSB_ERROR_NO_MEM;
+    ASSERT_EQ(usb_init(), -1);
+    reset_test_state();
+    mock_libusb_descriptor_rc = LIBUSB_ERROR_IO;
+    ASSERT_EQ(usb_init(), -1);
+    reset_test_state();
+    g_panel_cfg[0] = (PanelConfig){0x0416, 0x5302, 1, 9};
+    g_num_panels = 1;
+    ASSERT_EQ(usb_init(), -1);
+}
+
+TEST(usb_link_planning) {
+    /* Full-speed hub: 64-byte packets, whole frame, longer timeout. */
+    mock_libusb_speed = LIBUSB_SPEED_FULL;
+    mock_libusb_max_packet = 64;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(g_panels[0].max_packet, 64);
+    ASSERT_EQ(g_panels[0].unit, PACKET_SIZE);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), TRANSFER_SIZE);
+    ASSERT_EQ(g_panels[0].timeout_ms, 1000u + 2u * (TRANSFER_SIZE / 800));
+    usb_cleanup();
+
+    /* SuperSpeed: chunks and the packet fallback are whole 1024-byte packets. */
+    reset_test_state();
+    mock_libusb_speed = LIBUSB_SPEED_SUPER;
+    mock_libusb_max_packet = 0x1400; /* high-bandwidth bits are masked off */
+    mock_libusb_reject_len_above = 1024;
+    g_chunk_size = 3 * PACKET_SIZE;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT_EQ(g_panels[0].max_packet, 1024);
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), 2048);
+    ASSERT_EQ(g_panels[0].timeout_ms, 1000u);
+    ASSERT_EQ(send_frame(), 0);
+    usb_cleanup();
+    ASSERT_EQ(atomic_load(&g_panels[0].chunk), 1024);
+    ASSERT_EQ(mock_libusb_submit_calls, 1 + (TRANSFER_SIZE + 1023) / 1024);
+    ASSERT_EQ(mock_libusb_captured, (size_t)TRANSFER_SIZE);
+
+    ASSERT_STREQ(usb_speed_name(LIBUSB_SPEED_LOW), "low");
+    ASSERT_STREQ(usb_speed_name(LIBUSB_SPEED_HIGH), "high");
+    ASSERT_STREQ(usb_speed_name(LIBUSB_SPEED_SUPER_PLUS), "super+");
+    ASSERT_STREQ(usb_speed_name(LIBUSB_SPEED_UNKNOWN), "unknown");
+    ASSERT_EQ(usb_speed_bytes_per_ms(LIBUSB_SPEED_HIGH), 30000);
+    ASSERT_EQ(usb_speed_bytes_per_ms(LIBUSB_SPEED_SUPER_PLUS), 600000);
+}
+
+TEST(usb_transfer_stats) {
+    ASSERT_EQ(usb_init(), 0);
+    UsbStats *st = &g_panels[0].stats;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(st->completed, 1ULL);
+    ASSERT_EQ(st->bytes, (uint64_t)TRANSFER_SIZE);
+    ASSERT_EQ(st->hist[latency_bucket(st->max_us)], 1ULL);
+
+    /* A rejected large submission is retried in packets and counted. */
+    mock_libusb_reject_len_above = PACKET_SIZE;
+    framebuffer[0] = 1;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(st->retries, 1ULL);
+    ASSERT_EQ(st->completed, 2ULL);
+
+    mock_libusb_short_write = 1;
+    framebuffer[0] = 2;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(&g_panels[0]);
+    ASSERT_EQ(st->short_writes, 1ULL);
+    ASSERT_EQ(st->failed, 1ULL);
+    ASSERT_EQ(st->completed, 2ULL);
+
+    /* Summary lines are rate limited unless requested. */
+    struct timespec printed = g_stats_printed;
+    usb_report_stats(0);
+    ASSERT_EQ(g_stats_printed.tv_nsec, printed.tv_nsec);
+    g_stats_printed.tv_sec -= USB_STATS_PERIOD_S;
+    usb_report_stats(0);
+    ASSERT(g_stats_printed.tv_sec > printed.tv_sec - USB_STATS_PERIOD_S);
+    usb_report_stats(1);
+    usb_cleanup();
+
+    /* Percentiles report bucket bounds; the open last bucket reports the max. */
+    UsbStats hist = {0};
+    ASSERT_EQ(stats_percentile_us(&hist, 99), 0ULL);
+    hist.completed = 100;
+    hist.hist[latency_bucket(3000)] = 98;
+    hist.hist[USB_LAT_BUCKETS - 1] = 2;
+    hist.max_us = 20000000;
+    ASSERT_EQ(latency_bucket(0), 0);
+    ASSERT_EQ(latency_bucket(3000), 11);
+    ASSERT_EQ(stats_percentile_us(&hist, 50), 4096ULL);
+    ASSERT_EQ(stats_percentile_us(&hist, 99), 20000000ULL);
+}
+
+TEST(usb_frame_buffers) {
+    /* Slots live in usbfs memory of the open handle and carry the header. */
+    ASSERT_EQ(usb_init(), 0);
+    UsbPanel *p = &g_panels[0];
+    ASSERT_EQ(mock_libusb_dev_mem_mapped, USB_SLOTS);
+    ASSERT(p->slots[0].buf == p->slots[0].dma);
+    ASSERT(framebuffer == p->slots[0].dma + PACKET_SIZE / 2);
+    ASSERT_EQ(((uint8_t *)p->slots[1].buf)[0], 0xDA);
+    ASSERT_EQ((uintptr_t)p->slots[0].heap % (uintptr_t)sysconf(_SC_PAGESIZE), 0u);
+
+    /* Losing the device unmaps; the frame being drawn moves to the heap. */
+    framebuffer[7] = htole16(0x5A5A);
+    mock_libusb_transfer_fail_after = 0;
+    mock_libusb_transfer_status = LIBUSB_TRANSFER_NO_DEVICE;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(p);
+    framebuffer[9] = htole16(0xA5A5);
+    mock_libusb_open_ok = 0;
+    ASSERT_EQ(send_frame(), -1);
+    ASSERT_EQ(mock_libusb_dev_mem_mapped, 0);
+    ASSERT(framebuffer == p->slots[1].heap + PACKET_SIZE / 2);
+    ASSERT_EQ(le16toh(framebuffer[9]), 0xA5A5);
+
+    /* Re-open maps again and the pending frame goes out intact. */
+    mock_libusb_open_ok = 1;
+    mock_libusb_transfer_fail_after = -1;
+    p->last_attempt.tv_sec -= 10;
+    mock_libusb_captured = 0;
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(p);
+    ASSERT_EQ(mock_libusb_dev_mem_mapped, USB_SLOTS);
+    ASSERT_EQ(mock_libusb_capture[PACKET_SIZE + 18], 0xA5);
+    usb_cleanup();
+    ASSERT_EQ(mock_libusb_dev_mem_mapped, 0);
+    ASSERT(p->slots[0].heap == NULL);
+
+    /* Without usbfs mmap the heap buffers carry the frames. */
+    reset_test_state();
+    mock_libusb_dev_mem_ok = 0;
+    ASSERT_EQ(usb_init(), 0);
+    ASSERT(p->slots[0].dma == NULL);
+    ASSERT(framebuffer == p->slots[0].heap + PACKET_SIZE / 2);
+    clear_fb();
+    ASSERT_EQ(send_frame(), 0);
+    wait_transport_idle(p);
+    ASSERT_EQ(mock_libusb_capture[0], 0xDA);
+    usb_cleanup();
+
+    reset_test_state();
+    g_mock_posix_memalign_fail = 1;
+    ASSERT_EQ(usb_init(), -1);
+    ASSERT_EQ(usb_panel_count(), 0);
+}
+
 TEST(main_parse_failure) {
     char *argv[] = {"homelab-screen", "--interval", "0", NULL};
     ASSERT_EQ(homelab_screen_main(3, argv), 1);
@@ -1391,7 +3009,7 @@ TEST(main_success_single_loop_with_page_switch) {
     ASSERT_STREQ(g_metrics.net_iface, "eth0");
 }
 
-TEST(main_send_frame_failure_and_pve_pages) {
+TEST(main_survives_send_failure_with_pve_pages) {
     char *argv[] = {"homelab-screen", "--interface", "eth0", NULL};
 
     g_mock_nanosleep_enabled = 1;
@@ -1419,12 +3037,302 @@ TEST(main_send_frame_failure_and_pve_pages) {
     time_t times[] = {100, 100, 111};
     mock_set_times(times, 3);
 
-    mock_libusb_bulk_transfer_rc = -1;
+    mock_libusb_submit_rc = LIBUSB_ERROR_NO_DEVICE;
     ASSERT_EQ(homelab_screen_main(3, argv), 0);
     ASSERT_EQ(g_pve_metrics.pve_available, 1);
     ASSERT_EQ(last_pve_collect, (time_t)111);
-    ASSERT_EQ(g_mock_nanosleep_calls, 0);
-    ASSERT_EQ(mock_libusb_bulk_calls, 1);
+    ASSERT_EQ(g_mock_nanosleep_calls, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 1);
+    ASSERT(g_panels[0].handle == NULL);
+}
+
+TEST(main_prerenders_next_page) {
+    char *argv[] = {"homelab-screen", "--interface", "eth0", "--interval", "2", NULL};
+
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 1000 kB\nMemAvailable: 500 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
+    g_mock_access_enabled = 1;
+    mock_set_access("/usr/bin/pvesh", -1);
+    mock_set_access("/usr/sbin/qm", -1);
+
+    /* Start, then a tick one second before the switch and the switch itself. */
+    for (int run = 0; run < 2; run++) {
+        time_t times[] = {100, 101, 101, 101, 102, 102};
+        mock_set_times(times, 6);
+        g_mock_nanosleep_enabled = 1;
+        g_mock_nanosleep_calls = 0;
+        g_mock_nanosleep_stop_after = 2;
+        g_running = 1;
+        g_mock_malloc_fail = run; /* second run: no memory for offscreen frames */
+        mock_libusb_submit_calls = 0;
+
+        ASSERT_EQ(homelab_screen_main(5, argv), 0);
+        ASSERT_EQ(g_mock_nanosleep_calls, 2);
+        ASSERT_EQ(mock_libusb_submit_calls, 2);
+        g_mock_malloc_fail = 0;
+    }
+}
+
+/* Ticks that repaint nothing hand the frame over as unchanged; only the first goes out. */
+TEST(main_sends_unchanged_frames_once) {
+    char *argv[] = {"homelab-screen", "--interface", "eth0", "--interval", "60", "--palette", NULL};
+
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 1000 kB\nMemAvailable: 500 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    mock_set_file("/proc/loadavg", "1.0 2.0 3.0 0/0 1\n", 0);
+    g_mock_access_enabled = 1;
+    mock_set_access("/usr/bin/pvesh", -1);
+    mock_set_access("/usr/sbin/qm", -1);
+
+    for (int palette = 0; palette < 2; palette++) {
+        time_t times[] = {100};
+        mock_set_times(times, 1);
+        g_mock_nanosleep_enabled = 1;
+        g_mock_nanosleep_calls = 0;
+        g_mock_nanosleep_stop_after = 6;
+        g_running = 1;
+        optind = 1;
+        mock_libusb_submit_calls = 0;
+        ASSERT_EQ(homelab_screen_main(palette ? 6 : 5, argv), 0);
+        ASSERT_EQ(g_mock_nanosleep_calls, 6);
+        ASSERT_EQ(mock_libusb_submit_calls, 1);
+        ASSERT_EQ(g_panels[0].frames_skipped, 5ULL);
+        g_palette_mode = 0;
+    }
+}
+
+/* Pages drawn as palette indices expand to the pixels of an RGB565 frame. */
+TEST(render_indexed_matches_rgb565) {
+    static uint8_t idx[LCD_W * LCD_H];
+    static uint16_t out[LCD_W * LCD_H];
+    static uint16_t expect[LCD_W * LCD_H];
+    void (*pages[])(Surface *s) = {
+        render_page_overview, render_page_cpu, render_page_cores, render_page_memory,
+        render_page_network, render_page_system, render_page_proxmox, render_page_storage,
+    };
+    Surface indexed = surface_wrap_indexed(idx, LCD_W, LCD_H, LCD_W);
+
+    for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); p++) {
+        for (int variant = 0; variant < 2; variant++) {
+            set_widget_metrics(variant);
+            pages[p](&indexed);
+            surface_expand(out, &indexed);
+            render_fresh(pages[p], expect);
+            ASSERT(memcmp(out, expect, FRAME_SIZE) == 0);
+        }
+    }
+    /* The theme fits the byte-shuffle kernels. */
+    ASSERT(g_palette_count <= EXPAND8_SHUFFLE_MAX);
+
+    /* Primitives clipped at the edges of a surface inside a wider buffer. */
+    static uint8_t wide_idx[(LCD_W + 7) * 100];
+    static uint16_t wide[(LCD_W + 7) * 100];
+    Surface si = surface_wrap_indexed(wide_idx, LCD_W, 100, LCD_W + 7);
+    Surface s16 = surface_wrap(wide, LCD_W, 100, LCD_W + 7);
+    Surface *both[] = {&si, &s16};
+    for (int i = 0; i < 2; i++) {
+        fill_rect(both[i], -5, -5, LCD_W + 10, 110, COLOR_BG_CARD);
+        draw_circle_progress(both[i], 40, 90, 30, 6, 60.0f, COLOR_BG_GAUGE, COLOR_GREEN);
+        draw_circle_progress(both[i], 150, 50, 30, 6, 60.0f, COLOR_BG_GAUGE, COLOR_ORANGE);
+        draw_string(both[i], LCD_W - 20, 90, "Hi", COLOR_WHITE, 2);
+        draw_string(both[i], 20, 10, "Hi", COLOR_GRAY, 3);
+    }
+    surface_expand(out, &si);
+    for (int y = 0; y < 100; y++) {
+        ASSERT(memcmp(out + y * LCD_W, wide + y * (LCD_W + 7), LCD_W * sizeof(uint16_t)) == 0);
+    }
+
+    /* A full palette maps further colors to the nearest entry. */
+    static uint16_t saved[PALETTE_SIZE];
+    int saved_count = g_palette_count;
+    memcpy(saved, g_palette, sizeof(saved));
+    for (int c = 0; g_palette_count < PALETTE_SIZE; c++) {
+        palette_index((uint16_t)(0x1000 + c * 3));
+    }
+    ASSERT_EQ(le16toh(g_palette[palette_index(0x1002)]), 0x1003);
+    memcpy(g_palette, saved, sizeof(saved));
+    g_palette_count = saved_count;
+    g_palette_last = 0;
+}
+
+static void set_headless_files(void) {
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 1000 kB\nMemAvailable: 500 kB\n", 0);
+    mock_set_file("/proc/uptime", "100.0 0.0\n", 0);
+    g_mock_access_enabled = 1;
+    mock_set_access("/usr/bin/pvesh", -1);
+    mock_set_access("/usr/sbin/qm", -1);
+    time_t times[] = {100};
+    mock_set_times(times, 1);
+    last_cpu_idle = last_cpu_total = 0;
+}
+
+TEST(main_headless_snapshot) {
+    char dir[64], rgb_dir[PATH_MAX], pal_dir[PATH_MAX];
+    char a[sizeof(rgb_dir) + 16], b[sizeof(pal_dir) + 16];
+    ASSERT(make_temp_dir(dir, sizeof(dir)) == 0);
+    snprintf(rgb_dir, sizeof(rgb_dir), "%s/rgb", dir);
+    snprintf(pal_dir, sizeof(pal_dir), "%s/pal", dir);
+    ASSERT_EQ(mkdir(rgb_dir, 0700), 0);
+    ASSERT_EQ(mkdir(pal_dir, 0700), 0);
+
+    /* One tick of every page, without opening USB. */
+    char *argv[] = {"homelab-screen", "--interface", "eth0", "--render-to", rgb_dir, "--snapshot", NULL};
+    set_headless_files();
+    ASSERT_EQ(homelab_screen_main(6, argv), 0);
+    ASSERT_EQ(mock_libusb_submit_calls, 0);
+    ASSERT_EQ(g_panel_count, 0);
+
+    /* Palette frames expand to the same images. */
+    char *argv_pal[] = {"homelab-screen", "--interface", "eth0", "--render-to", pal_dir, "--snapshot",
+                        "--palette", NULL};
+    optind = 1;
+    set_headless_files();
+    ASSERT_EQ(homelab_screen_main(7, argv_pal), 0);
+    const char *names[] = {"overview", "cpu", "memory", "network", "system"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        snprintf(a, sizeof(a), "%s/%s.ppm", rgb_dir, names[i]);
+        snprintf(b, sizeof(b), "%s/%s.ppm", pal_dir, names[i]);
+        ASSERT(files_equal(a, b));
+    }
+    g_palette_mode = 0;
+
+    /* Looping until stopped, with the rate printed on SIGUSR1. */
+    char *argv_loop[] = {"homelab-screen", "--interface", "eth0", "--render-to", rgb_dir, NULL};
+    optind = 1;
+    g_snapshot = 0;
+    g_stats_requested = 1;
+    g_mock_nanosleep_enabled = 1;
+    g_mock_nanosleep_stop_after = 2;
+    ASSERT_EQ(homelab_screen_main(5, argv_loop), 0);
+    ASSERT_EQ(g_mock_nanosleep_calls, 2);
+    ASSERT_EQ(g_stats_requested, 0);
+
+    /* Unwritable directory, and no memory for the frames. */
+    snprintf(a, sizeof(a), "%s/missing", dir);
+    char *argv_bad[] = {"homelab-screen", "--interface", "eth0", "--render-to", a, "--snapshot", NULL};
+    optind = 1;
+    g_running = 1;
+    ASSERT_EQ(homelab_screen_main(6, argv_bad), 1);
+    optind = 1;
+    g_mock_malloc_fail = 1;
+    ASSERT_EQ(homelab_screen_main(6, argv_bad), 1);
+    g_mock_malloc_fail = 0;
+    remove_dir_recursive(dir);
+}
+
+TEST(main_palette_mode) {
+    char *argv[] = {"homelab-screen", "--interface", "eth0", "--interval", "2", "--palette", NULL};
+
+    g_mock_fs_enabled = 1;
+    mock_set_file("/proc/stat", "cpu 100 0 100 100 0 0 0\n", 0);
+    mock_set_file("/proc/meminfo", "MemTotal: 1000 kB\nMemAvailable: 500 kB\n", 0);
+    g_mock_access_enabled = 1;
+    mock_set_access("/usr/bin/pvesh", -1);
+    mock_set_access("/usr/sbin/qm", -1);
+
+    /* Pre-render, switch into the pre-rendered indexed frame, send both. */
+    time_t times[] = {100, 101, 101, 101, 102, 102};
+    mock_set_times(times, 6);
+    g_mock_nanosleep_enabled = 1;
+    g_mock_nanosleep_stop_after = 2;
+    ASSERT_EQ(homelab_screen_main(6, argv), 0);
+    ASSERT_EQ(g_palette_mode, 1);
+    ASSERT_EQ(mock_libusb_submit_calls, 2);
+
+    /* No memory for the indexed frames. */
+    optind = 1;
+    g_running = 1;
+    g_mock_malloc_fail = 1;
+    ASSERT_EQ(homelab_screen_main(6, argv), 1);
+    g_mock_malloc_fail = 0;
+}
+
+/*
+ * Every page, drawn from fixed metrics, matches its image in tests/golden.
+ * Run with UPDATE_GOLDEN=1 to rewrite the images after an intended change.
+ */
+TEST(render_matches_golden_images) {
+    static uint16_t fb[LCD_W * LCD_H];
+    struct {
+        void (*render)(Surface *s);
+        const char *name;
+    } pages[] = {
+        {render_page_overview, "overview"}, {render_page_cpu, "cpu"}, {render_page_cores, "cores"},
+        {render_page_memory, "memory"}, {render_page_network, "network"}, {render_page_system, "system"},
+        {render_page_proxmox, "proxmox"}, {render_page_storage, "storage"},
+    };
+    int update = getenv("UPDATE_GOLDEN") != NULL;
+    char dir[64], golden[PATH_MAX], out[PATH_MAX];
+    ASSERT(make_temp_dir(dir, sizeof(dir)) == 0);
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    set_widget_metrics(1);
+    for (size_t i = 0; i < sizeof(pages) / sizeof(pages[0]); i++) {
+        render_fresh(pages[i].render, fb);
+        snprintf(golden, sizeof(golden), "tests/golden/%s.ppm", pages[i].name);
+        snprintf(out, sizeof(out), "%s/%s.ppm", dir, pages[i].name);
+        ASSERT_EQ(write_ppm(update ? golden : out, fb, LCD_W, LCD_H), 0);
+        if (!update) {
+            ASSERT(files_equal(golden, out));
+        }
+    }
+
+    unsetenv("TZ");
+    tzset();
+    remove_dir_recursive(dir);
+}
+
+TEST(write_ppm_encoding_and_errors) {
+    char dir[64], path[PATH_MAX];
+    ASSERT(make_temp_dir(dir, sizeof(dir)) == 0);
+    snprintf(path, sizeof(path), "%s/px.ppm", dir);
+
+    /* White, pure red, green and blue widen to full channels. */
+    const uint16_t px[4] = {htole16(0xFFFF), htole16(0xF800), htole16(0x07E0), htole16(0x001F)};
+    ASSERT_EQ(write_ppm(path, px, 2, 2), 0);
+    static const uint8_t expect[] = "P6\n2 2\n255\n\xFF\xFF\xFF\xFF\0\0\0\xFF\0\0\0\xFF";
+    uint8_t got[sizeof(expect)] = {0};
+    FILE *f = libc_fopen(path, "rb");
+    ASSERT(f != NULL);
+    ASSERT_EQ(fread(got, 1, sizeof(got), f), sizeof(expect) - 1);
+    fclose(f);
+    ASSERT(memcmp(got, expect, sizeof(expect) - 1) == 0);
+
+    snprintf(path, sizeof(path), "%s/missing/px.ppm", dir);
+    ASSERT_EQ(write_ppm(path, px, 2, 2), -1);
+    ASSERT_EQ(write_ppm("/dev/full", px, 2, 2), -1);
+    g_mock_malloc_fail = 1;
+    ASSERT_EQ(write_ppm("/dev/null", px, 2, 2), -1);
+    ASSERT_EQ(errno, ENOMEM);
+    g_mock_malloc_fail = 0;
+    remove_dir_recursive(dir);
+}
+
+TEST(render_seeds_from_prerendered_frame) {
+    static uint16_t next[LCD_W * LCD_H];
+    Surface off = surface_wrap(next, LCD_W, LCD_H, LCD_W);
+
+    /* Pre-render with stale values, marking a static pixel only it has. */
+    set_widget_metrics(0);
+    clear_fb();
+    render_page_cpu(&off);
+    next[0] = 0x1234;
+
+    /* The switch copies the pre-rendered frame and patches the values. */
+    set_widget_metrics(1);
+    render_page_cpu(test_surface());
+    ASSERT_EQ(g_test_fb[0], 0x1234);
+    g_test_fb[0] = next[0] = 0;
+    render_fresh(render_page_cpu, next);
+    ASSERT(memcmp(g_test_fb, next, FRAME_SIZE) == 0);
 }
 
 /* ===== test runner ===== */
@@ -1437,10 +3345,22 @@ int main(void) {
     RUN(set_pixel_valid);
     RUN(set_pixel_out_of_bounds);
     RUN(fill_rect_clipping);
+    RUN(pixel_kernels_match_scalar);
     RUN(draw_char_and_strings);
+    RUN(glyph_spans_match_bitmap);
+    RUN(rounded_rect_spans_match_pixels);
     RUN(progress_and_circle);
+    RUN(circle_progress_matches_trig_reference);
     RUN(format_bytes_helpers);
     RUN(render_pages_all_paths);
+    RUN(render_damage_matches_full_redraw);
+    RUN(render_cores_heatmap);
+    RUN(render_backgrounds_follow_names);
+    RUN(render_into_offscreen_surface);
+    RUN(render_seeds_from_prerendered_frame);
+    RUN(render_matches_golden_images);
+    RUN(write_ppm_encoding_and_errors);
+    RUN(render_indexed_matches_rgb565);
 
     printf("\n[CLI]\n");
     RUN(parse_hex_and_int_helpers);
@@ -1449,7 +3369,14 @@ int main(void) {
 
     printf("\n[Metrics]\n");
     RUN(compute_counter_rate_cases);
+    RUN(proc_parsers_on_truncated_input);
+    RUN(get_memory_info_fallbacks);
     RUN(get_cpu_usage_paths);
+    RUN(get_cpu_usage_per_core);
+    RUN(collect_metrics_reuses_sources);
+    RUN(collect_metrics_schedule);
+    RUN(metrics_snapshots_are_consistent);
+    RUN(collector_thread_publishes);
     RUN(get_memory_temp_host_load_uptime_paths);
     RUN(detect_network_interface_paths);
     RUN(get_network_rates_and_collect_metrics);
@@ -1466,6 +3393,17 @@ int main(void) {
     RUN(usb_init_error_paths);
     RUN(usb_init_success_and_cleanup);
     RUN(send_frame_paths);
+    RUN(send_frame_packet_mode_paths);
+    RUN(send_frame_chunking_and_fallback);
+    RUN(send_frame_stall_mid_frame);
+    RUN(send_frame_skips_unchanged_frames);
+    RUN(usb_reconnects_on_hotplug_arrival);
+    RUN(usb_reconnect_backoff_without_hotplug);
+    RUN(usb_multiple_panels);
+    RUN(usb_link_planning);
+    RUN(usb_transfer_stats);
+    RUN(usb_frame_buffers);
+    RUN(pixel_hash64_properties);
     RUN(mock_libusb_direct_paths);
 
     printf("\n[Main]\n");
@@ -1473,7 +3411,11 @@ int main(void) {
     RUN(main_parse_failure);
     RUN(main_usb_init_failure);
     RUN(main_success_single_loop_with_page_switch);
-    RUN(main_send_frame_failure_and_pve_pages);
+    RUN(main_survives_send_failure_with_pve_pages);
+    RUN(main_prerenders_next_page);
+    RUN(main_sends_unchanged_frames_once);
+    RUN(main_palette_mode);
+    RUN(main_headless_snapshot);
 
     printf("\n=======================\n");
     printf("Results: %d passed, %d failed\n", g_pass, g_fail);